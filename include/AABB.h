@@ -15,19 +15,23 @@
 
 #include "rtweekend.h"
 
-class AABB {
+template <typename T>
+class basic_AABB {
 public:
+    using interval = basic_interval<T>;
+    using point3 = basic_vec3<T>;
+
     interval x, y, z;
 
-    AABB() = default; // The default AABB is empty, since intervals are empty by default.
+    basic_AABB() = default; // The default AABB is empty, since intervals are empty by default.
 
-    AABB(const interval& x, const interval& y, const interval& z)
+    basic_AABB(const interval& x, const interval& y, const interval& z)
         : x(x), y(y), z(z)
     {
       pad_to_minimums();
     }
 
-    AABB(const point3& a, const point3& b) {
+    basic_AABB(const point3& a, const point3& b) {
         //Treat the two points a and b as extrema for the bounding box,
         //so we don't require a particular minimum or maximum coordinate order.
 
@@ -38,7 +42,7 @@ public:
         pad_to_minimums();
     }
 
-    AABB(const AABB& box1, const AABB& box2) {
+    basic_AABB(const basic_AABB& box1, const basic_AABB& box2) {
         // Create the AABB tightly enclosing the two input AABBs.
         x = interval(box1.x, box2.x);
         y = interval(box1.y, box2.y);
@@ -52,33 +56,38 @@ public:
         return x;
     }
 
-    bool hit(const ray& r, interval ray_t) const {
+    bool hit(const basic_ray<T>& r, interval ray_t) const {
+        T entry;
+        return hit(r, ray_t, entry);
+    }
+
+    bool hit(const basic_ray<T>& r, interval ray_t, T& entry) const {
         // Check for intersection with the AABB.
         // The AABB is hit if the ray intersects all three axis-aligned intervals.
-
-        const point3&   ray_orig    = r.origin();
-        const vec3&     ray_dir     = r.direction();
+        // On a hit, entry is the distance at which the ray enters the box (or ray_t.min if
+        // it starts inside).
+        // The sign of the direction picks the near and far bound of every axis, so the
+        // distances to both come from the ray's cached reciprocal direction with no branch.
+        // A ray parallel to a slab and lying in one of its planes gets a NaN distance, which
+        // fails both comparisons and leaves the interval unchanged: such grazing rays count
+        // as hits.
+        const point3&        ray_orig = r.origin();
+        const basic_vec3<T>& inv_dir  = r.inv_direction();
+        const interval*      slabs[3] = {&x, &y, &z};
 
         for (int axis = 0; axis < 3; ++axis) {
-            const interval& ax = axis_interval(axis);
-            const double adinv = 1.0 / ray_dir[axis];
-
-            auto t0 = (ax.min - ray_orig[axis]) * adinv;
-            auto t1 = (ax.max - ray_orig[axis]) * adinv;
-
-            // Ensure t0 is the intersection with the near plane.
-            if (t0 < t1) {
-                if (t0 > ray_t.min) ray_t.min = t0;
-                if (t1 < ray_t.max) ray_t.max = t1;
-            } else {
-                if (t1 > ray_t.min) ray_t.min = t1;
-                if (t0 < ray_t.max) ray_t.max = t0;
-            }
-
-            if (ray_t.max <= ray_t.min)
-                return false;
+            const interval& slab = *slabs[axis];
+            const T near_plane = r.sign(axis) ? slab.max : slab.min;
+            const T far_plane = r.sign(axis) ? slab.min : slab.max;
+
+            const T t_near = (near_plane - ray_orig[axis]) * inv_dir[axis];
+            const T t_far = (far_plane - ray_orig[axis]) * inv_dir[axis];
+            ray_t.min = t_near > ray_t.min ? t_near : ray_t.min;
+            ray_t.max = t_far < ray_t.max ? t_far : ray_t.max;
         }
-        return true;
+
+        entry = ray_t.min;
+        return ray_t.min < ray_t.max;
     }
 
     int longest_axis() const {
@@ -89,31 +98,90 @@ public:
             return y.size() > z.size() ? 1 : 2;
     }
 
-    static const AABB empty, universe;
+    T surface_area() const {
+        // Return the surface area of the box, the measure of how likely a ray is to hit it.
+        auto dx = x.size(), dy = y.size(), dz = z.size();
+        return 2 * (dx * dy + dy * dz + dz * dx);
+    }
+
+    point3 centroid() const {
+        // Return the center of the box.
+        return point3((x.min + x.max) / 2, (y.min + y.max) / 2, (z.min + z.max) / 2);
+    }
+
+    static const basic_AABB empty, universe;
 
  private:
 
   void pad_to_minimums() {
     // Adjust the AABB so that no side is narrower than some delta, padding if necessary.
 
-    const double delta = 0.0001;
+    const T delta = 0.0001;
     if (x.size() < delta) x = x.expand(delta);
     if (y.size() < delta) y = y.expand(delta);
     if (z.size() < delta) z = z.expand(delta);
   }
 };
 
-const AABB AABB::empty = AABB(interval::empty, interval::empty, interval::empty);
-const AABB AABB::universe = AABB(interval::universe, interval::universe, interval::universe);
+template <typename T>
+const basic_AABB<T> basic_AABB<T>::empty =
+    basic_AABB<T>(basic_interval<T>::empty, basic_interval<T>::empty, basic_interval<T>::empty);
+template <typename T>
+const basic_AABB<T> basic_AABB<T>::universe =
+    basic_AABB<T>(basic_interval<T>::universe, basic_interval<T>::universe, basic_interval<T>::universe);
 
-AABB operator+(const AABB& bbox, const vec3& offset) {
+template <typename T>
+basic_AABB<T> operator+(const basic_AABB<T>& bbox, const basic_vec3<T>& offset) {
     // Return the AABB translated by the given offset.
     return {bbox.x + offset.x(), bbox.y + offset.y(), bbox.z + offset.z()};
 }
 
-AABB operator+(const vec3& offset, const AABB& bbox) {
+template <typename T>
+basic_AABB<T> operator+(const basic_vec3<T>& offset, const basic_AABB<T>& bbox) {
     // Return the AABB translated by the given offset.
     return bbox + offset;
 }
 
+template <typename T>
+class basic_motion_box {
+    // The bounds of a moving object at the start (time 0) and end (time 1) of the shutter.
+    // The box at any time in between is their linear interpolation, which bounds an object
+    // moving linearly exactly, and bounds the union of such objects conservatively.
+public:
+    using AABB = basic_AABB<T>;
+
+    AABB start, end;
+
+    basic_motion_box() = default;
+
+    basic_motion_box(const AABB& start, const AABB& end) : start(start), end(end) {}
+
+    basic_motion_box(const basic_motion_box& a, const basic_motion_box& b)
+        : start(a.start, b.start), end(a.end, b.end) {}
+
+    bool moves() const {
+        // Whether the box at the end differs from the one at the start.
+        return start.x.min != end.x.min || start.x.max != end.x.max
+            || start.y.min != end.y.min || start.y.max != end.y.max
+            || start.z.min != end.z.min || start.z.max != end.z.max;
+    }
+
+    AABB at(T time) const {
+        // The box at the given time.
+        AABB box;
+        box.x = basic_interval<T>(start.x.min + time * (end.x.min - start.x.min), start.x.max + time * (end.x.max - start.x.max));
+        box.y = basic_interval<T>(start.y.min + time * (end.y.min - start.y.min), start.y.max + time * (end.y.max - start.y.max));
+        box.z = basic_interval<T>(start.z.min + time * (end.z.min - start.z.min), start.z.max + time * (end.z.max - start.z.max));
+        return box;
+    }
+
+    AABB swept() const {
+        // The box covering the whole motion.
+        return AABB(start, end);
+    }
+};
+
+using AABB = basic_AABB<real>;
+using motion_box = basic_motion_box<real>;
+
 #endif //RAYTRACINGINONEWEEKEND_AABB_H
@@ -7,7 +7,22 @@
  * @File: bvh.h
  * @Software: CLion
  * @Project: RayTracingInOneWeekend
- * @Description:
+ * @Description: The bvh_node class is a bounding volume hierarchy over a list of hittables.
+ * It is built and stored as the flat binary tree of flat_bvh.h: split at the object median,
+ * with the surface area heuristic (SAH) or as a linear BVH (LBVH), into leaves of up to
+ * max_leaf_size primitives, on several threads when the tree is large. The nodes are one
+ * array in depth-first order, and the primitives of every leaf are a range of one pointer
+ * array. Traversal is a loop over this array with a small stack, and only the primitives in
+ * the leaves are virtual calls.
+ * With a width of 4 or 8 the binary tree is collapsed into a wide BVH: every node holds the
+ * boxes of up to that many children in SoA form, tests them all against a ray with one SIMD
+ * slab test, and visits the children that are hit nearest first.
+ * Objects wrapped in chains of transforms are collapsed into instances (see instance.h), so a
+ * BVH over instances of shared BVHs forms a two-level structure.
+ * When objects move, the box of every node is its box at the start of the shutter, a second
+ * array holds how fast its bounds move, and a ray tests the box at its time instead of the
+ * box swept over the whole motion.
+ * Objects that move far for their size get a tree per time segment of the shutter.
  */
 
 
@@ -15,89 +30,567 @@
 #define RAYTRACINGINONEWEEKEND_BVH_H
 
 #include "AABB.h"
+#include "flat_bvh.h"
 #include "hittable.h"
 #include "hittable_list.h"
+#include "instance.h"
+#include "simd.h"
+#include "stats.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+struct bvh_quality {
+    int    nodes     = 0;  // Interior nodes and leaves
+    int    leaves    = 0;
+    int    max_depth = 0;
+    double sah_cost  = 0;  // Expected cost of a ray that hits the root box, under the SAH
+    size_t bytes     = 0;  // Memory of the nodes, their motion bounds and the primitive pointers
+    int    segments  = 1;  // Time segments of a motion BVH, whose totals these are
+};
+
+struct linear_bvh_motion {
+    // The change of the bounds of a node of a motion BVH over its shutter: at time t of the
+    // shutter (from 0 to 1) the node's box is its box at the start plus t times these.
+    real min[3];
+    real max[3];
+};
+
+template <int N>
+struct alignas(64) wide_bvh_node {
+    // A node of a wide BVH: the boxes of its children in SoA form, so that every bound of
+    // every child loads as one lane type. A child is either a node or, when its count is not
+    // 0, a leaf: a range of primitives stored directly in the slot.
+    real     bounds[6][N];  // Minimum x, y, z then maximum x, y, z of every child
+    uint32_t child[N];      // Interior children: node index. Leaves: first primitive
+    uint16_t count[N];      // Number of primitives of a leaf child; 0 for interior children
+    uint8_t  children;      // Number of slots in use
+};
 
 class bvh_node : public hittable {
 
 public:
-    explicit bvh_node(hittable_list list) : bvh_node(list.objects,
-                                            0, list.objects.size()) {
-        // There's a C++ subtlety here.
-        // This constructor (without span indices) creates an implicit copy of the hittable
-        // list, which we will modify. The lifetime of the copied list only extends until
-        // this constructor exits. That's OK, because we only need to persist the resulting
-        // bounding volume hierarchy.
-    }
-
-    bvh_node(std::vector<shared_ptr<hittable>>& objects, size_t start, size_t end) {
-        // Build the  bounding box of the span of source objects.
-        bbox = AABB::empty;
-        for (size_t object_index = start; object_index < end; object_index++) {
-            bbox = AABB(bbox, objects[object_index]->bounding_box());
-        }
-        int axis = bbox.longest_axis();
-
-        // Compare the objects along the chosen axis.
-        auto comparator = (axis == 0) ? box_x_compare
-                        : (axis == 1) ? box_y_compare
-                        : box_z_compare;
-
-        size_t object_span = end - start;
-
-        if (object_span == 1) {
-            left = right = objects[start];
-        } else if (object_span == 2) {
-            left = objects[start];
-            right = objects[start + 1];
-        } else {
-            std::sort(std::begin(objects) + start, std::begin(objects) + end, comparator);
+    explicit bvh_node(hittable_list list) : bvh_node(std::move(list), bvh_build_options()) {}
+
+    bvh_node(hittable_list list, const bvh_build_options& options) {
+        // Chains of transform wrappers are collapsed into single instances first, so that
+        // this BVH is the top level over them. If objects move far enough compared to their
+        // size, the bounds of the objects at both ends of the shutter are kept for a motion
+        // BVH, which is split into time segments of its own when they move farther still.
+        objects = std::move(list.objects);
+        if (objects.empty())
+            return;
+
+        int threads = build_threads(options);
+
+        if (options.motion_blur)
+            object_motion.resize(objects.size());
+        parallel_for(objects.size(), threads, [&](size_t begin, size_t end) {
+            for (size_t index = begin; index < end; ++index) {
+                objects[index] = collapse_transforms(objects[index]);
+                if (options.motion_blur)
+                    object_motion[index] = objects[index]->motion_bounding_box();
+            }
+        });
+        if (std::none_of(object_motion.begin(), object_motion.end(), [](const motion_box& m) { return m.moves(); }))
+            std::vector<motion_box>().swap(object_motion);
 
-            auto mid = start + object_span / 2;
-            left = make_shared<bvh_node>(objects, start, mid);
-            right = make_shared<bvh_node>(objects, mid, end);
+        int segments = object_motion.empty() ? 1
+                       : options.motion_segments > 0 ? options.motion_segments
+                       : motion_segment_count();
+        if (segments == 0)
+            std::vector<motion_box>().swap(object_motion);
+        if (segments <= 1) {
+            build_tree(options, threads);
+            return;
         }
-//        bbox = AABB(left->bounding_box(), right->bounding_box());
+
+        for (int k = 0; k < segments; ++k) {
+            interval window(real(k) / segments, real(k + 1) / segments);
+            segment_trees.push_back(shared_ptr<bvh_node>(new bvh_node(objects, object_motion, window, options, threads)));
+            bbox = AABB(bbox, segment_trees.back()->bbox);
+        }
+        std::vector<motion_box>().swap(object_motion);
     }
 
     bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
-        if (!bbox.hit(r, ray_t))
-            return false;
+        if (!segment_trees.empty()) {
+            auto k = static_cast<int>(r.time() * static_cast<real>(segment_trees.size()));
+            k = std::clamp(k, 0, static_cast<int>(segment_trees.size()) - 1);
+            return segment_trees[k]->hit(r, ray_t, rec);
+        }
+        switch (width) {
+            case 4:  return hit_wide(wide4, r, ray_t, rec);
+            case 8:  return hit_wide(wide8, r, ray_t, rec);
+            default: return hit_subtree(0, r, ray_t, rec);
+        }
+    }
+
+    lane_mask hit_packet(ray_packet& packet, lane_mask mask, hit_record* recs) const override {
+        // The packet descends like a single ray, with the mask of its lanes still inside the
+        // node. Every node is culled for the whole packet against its frustum, then slab
+        // tested lane by lane. The lanes of a wide BVH, which is vectorized over the children
+        // of a node instead, are traced one by one, as are those of a segmented motion BVH.
+        // In a motion BVH the packet tests the boxes swept over the shutter, which hold the
+        // boxes of every lane's time.
+        if (width != 2 || !segment_trees.empty())
+            return hittable::hit_packet(packet, mask, recs);
+        if (nodes.empty())
+            return 0;
+
+        struct entry { uint32_t index; lane_mask mask; };
+        entry stack[bvh_max_depth];
+        int top = 0;
+        stack[top++] = {0, mask};
+        lane_mask hits = 0;
+
+        while (top > 0) {
+            auto [index, lanes] = stack[--top];
+            const auto& node = nodes[index];
+            const AABB box = swept_box(index);
+
+            if (packet.frustum_misses(box, lanes))
+                continue;
+            lanes = packet.hit_mask(box, lanes);
+            if (!lanes)
+                continue;
 
-        bool hit_left = left->hit(r, ray_t, rec);
-        bool hit_right = right->hit(r, interval(ray_t.min,
-                                                hit_left ? rec.t : ray_t.max), rec);
+            if (lane_count(lanes) < packet_min_lanes) {
+                // Once the packet has diverged, the lanes left are cheaper to trace one at a time.
+                for (int lane = 0; lane < packet_width; ++lane)
+                    if ((lanes & (1u << lane)) && hit_subtree_lane(index, packet, lane, recs[lane]))
+                        hits |= 1u << lane;
+                continue;
+            }
 
-        return hit_left || hit_right;
+            if (node.count > 0) {
+                for (uint32_t i = node.offset; i < node.offset + node.count; ++i)
+                    hits |= primitives[i]->hit_packet(packet, lanes, recs);
+                continue;
+            }
+
+            // The child on the near side of the split for the packet's direction is visited
+            // first: it is pushed last. (A packet that is not coherent goes by its first lane.)
+            int lane = 0;
+            while (!(lanes & (1u << lane)))
+                ++lane;
+            const real* directions[3] = {packet.dx, packet.dy, packet.dz};
+            bool backwards = directions[node.axis][lane] < 0;
+            stack[top++] = {backwards ? index + 1 : node.offset, lanes};
+            stack[top++] = {backwards ? node.offset : index + 1, lanes};
+        }
+
+        return hits;
     }
 
     AABB bounding_box() const override {
         return bbox;
     }
 
+    [[nodiscard]] motion_box motion_bounding_box() const override {
+        // The interpolated root box; a segmented tree is not linear over the whole shutter.
+        if (motion.empty() || !segment_trees.empty())
+            return hittable::motion_bounding_box();
+        return {box_at(0, 0), box_at(0, 1)};
+    }
+
+    [[nodiscard]] bvh_quality quality(const bvh_build_options& costs = {}) const {
+        // Size and depth of the tree, and its SAH cost: every node costs its traversal (and a
+        // leaf its primitive tests) weighted by the chance that a ray through the root box
+        // also passes through the node's box. The boxes of a motion BVH are those swept over
+        // its shutter; a segmented one reports the totals of its segments.
+        if (!segment_trees.empty()) {
+            bvh_quality q;
+            q.segments = static_cast<int>(segment_trees.size());
+            for (const auto& tree : segment_trees) {
+                auto t = tree->quality(costs);
+                q.nodes += t.nodes;
+                q.leaves += t.leaves;
+                q.max_depth = std::max(q.max_depth, t.max_depth);
+                q.sah_cost += t.sah_cost / q.segments;
+                q.bytes += t.bytes;
+            }
+            return q;
+        }
+        if (width == 4)
+            return wide_quality(wide4, costs);
+        if (width == 8)
+            return wide_quality(wide8, costs);
+
+        bvh_quality q;
+        q.bytes = nodes.size() * sizeof(linear_bvh_node) + motion.size() * sizeof(linear_bvh_motion)
+                  + primitives.size() * sizeof(const hittable*);
+        if (nodes.empty())
+            return q;
+
+        double root_area = swept_box(0).surface_area();
+        struct entry { uint32_t index; int depth; };
+        std::vector<entry> stack = {{0, 1}};
+        while (!stack.empty()) {
+            auto [index, depth] = stack.back();
+            stack.pop_back();
+            const auto& node = nodes[index];
+
+            double weight = root_area > 0 ? swept_box(index).surface_area() / root_area : 1;
+            q.nodes++;
+            q.max_depth = std::max(q.max_depth, depth);
+            if (node.count > 0) {
+                q.leaves++;
+                q.sah_cost += weight * costs.intersection_cost * node.count;
+            } else {
+                q.sah_cost += weight * costs.traversal_cost;
+                stack.push_back({index + 1, depth + 1});
+                stack.push_back({node.offset, depth + 1});
+            }
+        }
+        return q;
+    }
+
 private:
-    shared_ptr<hittable> left;
-    shared_ptr<hittable> right;
-    AABB bbox;
+    // Most time segments of a motion BVH, and how much larger than the moving objects the
+    // boxes they sweep (over the shutter, or over one segment) must be on average for a
+    // motion BVH to be built, and for the shutter to be split further.
+    static constexpr int    max_motion_segments = 8;
+    static constexpr double motion_min_growth   = 2.0;
+    static constexpr double motion_growth_limit = 6.0;
+
+    std::vector<linear_bvh_node>      nodes;       // Depth-first; the root is nodes[0]
+    std::vector<wide_bvh_node<4>>     wide4;       // The nodes instead, with a width of 4...
+    std::vector<wide_bvh_node<8>>     wide8;       // ...or of 8
+    std::vector<const hittable*>      primitives;  // Objects of the leaves, leaf by leaf
+    std::vector<linear_bvh_motion>    motion;      // Motion BVH: how fast the node bounds move
+    std::vector<shared_ptr<bvh_node>> segment_trees;  // Trees of the time segments, if split
+    std::vector<motion_box>           object_motion;  // Bounds of the objects, while building
+    std::vector<shared_ptr<hittable>> objects;     // Keeps the objects alive
+    interval shutter = interval(0, 1);             // Times covered by the motion bounds
+    AABB bbox = AABB::empty;
+    int  width = 2;
+
+    bvh_node(const std::vector<shared_ptr<hittable>>& list, const std::vector<motion_box>& motion_bounds,
+             interval window, const bvh_build_options& options, int threads)
+        : objects(list), shutter(window) {
+        // The tree of one time segment of a motion BVH: the objects' bounds are interpolated
+        // to the ends of the segment, and the tree built over the box they sweep within it.
+        object_motion.resize(motion_bounds.size());
+        parallel_for(motion_bounds.size(), threads, [&](size_t begin, size_t end) {
+            for (size_t index = begin; index < end; ++index)
+                object_motion[index] = {motion_bounds[index].at(window.min), motion_bounds[index].at(window.max)};
+        });
+        build_tree(options, threads);
+    }
+
+    void build_tree(const bvh_build_options& options, int threads) {
+        // Builds the tree over the objects. The bounding box and centroid of every object
+        // are computed once, up front; the builders then only move these records around.
+        std::vector<bvh_build_primitive> prims(objects.size());
+        parallel_for(prims.size(), threads, [&](size_t begin, size_t end) {
+            for (size_t index = begin; index < end; ++index) {
+                auto box = object_motion.empty() ? objects[index]->bounding_box() : object_motion[index].swept();
+                prims[index] = {box, box.centroid(), index, 0};
+            }
+        });
+
+        auto tree = build_flat_bvh<const hittable*>(prims, options, threads,
+                                                    [&](size_t index) { return objects[index].get(); },
+                                                    object_motion);
+        nodes = std::move(tree.nodes);
+        primitives = std::move(tree.primitives);
+        bbox = nodes[0].box;
+        std::vector<motion_box>().swap(object_motion);
+
+        // A wide BVH replaces the binary nodes it is collapsed from, and tests the boxes
+        // swept over the shutter.
+        width = options.width >= 8 ? 8 : options.width >= 4 ? 4 : 2;
+        if (width == 4)
+            collapse(0, wide4);
+        else if (width == 8)
+            collapse(0, wide8);
+        if (width != 2) {
+            std::vector<linear_bvh_node>().swap(nodes);
+            return;
+        }
+
+        // A binary motion BVH keeps the box of every node at the start of the shutter, next
+        // to its links where the traversal reads it, and the motion of its bounds apart.
+        if (!tree.motion.empty()) {
+            motion.resize(nodes.size());
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                const auto& m = tree.motion[i];
+                for (int axis = 0; axis < 3; ++axis) {
+                    motion[i].min[axis] = m.end.axis_interval(axis).min - m.start.axis_interval(axis).min;
+                    motion[i].max[axis] = m.end.axis_interval(axis).max - m.start.axis_interval(axis).max;
+                }
+                nodes[i].box = m.start;
+            }
+        }
+    }
+
+    AABB box_at(uint32_t index, real time) const {
+        // The box of a node at the given time of its shutter, from 0 to 1.
+        const AABB& start = nodes[index].box;
+        const auto& m = motion[index];
+        AABB box;
+        box.x = interval(start.x.min + time * m.min[0], start.x.max + time * m.max[0]);
+        box.y = interval(start.y.min + time * m.min[1], start.y.max + time * m.max[1]);
+        box.z = interval(start.z.min + time * m.min[2], start.z.max + time * m.max[2]);
+        return box;
+    }
+
+    AABB swept_box(uint32_t index) const {
+        // The box of a node over its whole shutter.
+        return motion.empty() ? nodes[index].box : AABB(box_at(index, 0), box_at(index, 1));
+    }
+
+    int motion_segment_count() const {
+        // The fewest time segments over which the boxes swept by the moving objects are at
+        // most motion_growth_limit times the area of their boxes at the segment's ends. The
+        // bounds interpolated between the ends are loose where objects that move apart
+        // share a node, which gets worse the farther they move relative to their size.
+        // Returns 0 when the objects move so little that the swept boxes are nearly as
+        // tight, and cheaper to test.
+        for (int k = 1; k < max_motion_segments; ++k) {
+            double swept_area = 0, area = 0;
+            for (const auto& m : object_motion) {
+                if (!m.moves())
+                    continue;
+                auto start = m.at(0), end = m.at(real(1) / k);
+                swept_area += AABB(start, end).surface_area();
+                area += (start.surface_area() + end.surface_area()) / 2;
+            }
+            if (k == 1 && swept_area <= motion_min_growth * area)
+                return 0;
+            if (swept_area <= motion_growth_limit * area)
+                return k;
+        }
+        return max_motion_segments;
+    }
+
+    bool hit_subtree(uint32_t root, const ray& r, interval ray_t, hit_record& rec) const {
+        // Closest hit in the subtree of the given node, front to back (see hit_flat_bvh).
+        if (nodes.empty())
+            return false;
+
+        // A motion BVH tests the boxes of its nodes interpolated at the time of the ray.
+        // (The arrays are read through local pointers, which the primitives' virtual calls
+        // cannot invalidate, so that they are not reloaded after every primitive test.)
+        const linear_bvh_node* node_array = nodes.data();
+        const linear_bvh_motion* moving = motion.empty() ? nullptr : motion.data();
+        const hittable* const* leaf_primitives = primitives.data();
+        const real time = moving ? std::clamp((r.time() - shutter.min) / shutter.size(), real(0), real(1)) : 0;
+        auto hit_box = [&](uint32_t i, const interval& t, real& entry) {
+            if (!moving)
+                return node_array[i].box.hit(r, t, entry);
+            const AABB& start = node_array[i].box;
+            AABB box;
+            box.x = interval(start.x.min + time * moving[i].min[0], start.x.max + time * moving[i].max[0]);
+            box.y = interval(start.y.min + time * moving[i].min[1], start.y.max + time * moving[i].max[1]);
+            box.z = interval(start.z.min + time * moving[i].min[2], start.z.max + time * moving[i].max[2]);
+            return box.hit(r, t, entry);
+        };
+        auto hit_leaf = [&](const linear_bvh_node& leaf, interval& t) {
+            bool hit_anything = false;
+            for (uint32_t i = leaf.offset; i < leaf.offset + leaf.count; ++i) {
+                RTW_COUNT(primitive_tests);
+                if (leaf_primitives[i]->hit(r, t, rec)) {
+                    hit_anything = true;
+                    t.max = rec.t;
+                }
+            }
+            return hit_anything;
+        };
+
+        return hit_flat_bvh(node_array, root, ray_t, hit_box, hit_leaf);
+    }
+
+    bool hit_subtree_lane(uint32_t root, ray_packet& packet, int lane, hit_record& rec) const {
+        // Traces one lane of a packet through a subtree as a single ray, drawing from the
+        // lane's random stream (see hittable::hit_lane).
+        auto& rng = thread_rng();
+        std::swap(rng, packet.rngs[lane]);
+        bool hit_anything = hit_subtree(root, packet.rays[lane], interval(packet.t_min, packet.t_max[lane]), rec);
+        std::swap(rng, packet.rngs[lane]);
 
-    static bool box_compare(
-            const shared_ptr<hittable>& a, const shared_ptr<hittable>& b, int axis_index) {
-        auto a_axis_interval = a->bounding_box().axis_interval(axis_index);
-        auto b_axis_interval = b->bounding_box().axis_interval(axis_index);
-        return a_axis_interval.min < b_axis_interval.min;
+        if (hit_anything)
+            packet.t_max[lane] = rec.t;
+        return hit_anything;
     }
 
-    static bool box_x_compare(const shared_ptr<hittable>& a, const shared_ptr<hittable>& b) {
-        return box_compare(a, b, 0);
+    template <int N>
+    bool hit_wide(const std::vector<wide_bvh_node<N>>& wide, const ray& r, interval ray_t, hit_record& rec) const {
+        // Closest hit in a wide BVH. The slab test is that of AABB::hit, on all the children
+        // of a node at once; the children hit are pushed farthest first, so that the nearest
+        // is visited next, and are skipped when popped if a closer hit has been found since.
+        using lanes = basic_lanes<real, N>;
+        if (wide.empty())
+            return false;
+
+        lanes origin[3], inv_dir[3];
+        int near_bound[3];
+        for (int axis = 0; axis < 3; ++axis) {
+            origin[axis] = lanes(r.origin()[axis]);
+            inv_dir[axis] = lanes(r.inv_direction()[axis]);
+            near_bound[axis] = r.sign(axis) ? axis + 3 : axis;
+        }
+
+        struct entry {
+            uint32_t index;  // Node index, or first primitive of a leaf
+            uint16_t count;  // Primitives of a leaf; 0 for a node
+            real     near;   // Distance at which the ray enters the box
+        };
+        entry stack[(N - 1) * bvh_max_depth + 1];
+        int top = 0;
+        stack[top++] = {0, 0, ray_t.min};
+        bool hit_anything = false;
+
+        while (top > 0) {
+            auto e = stack[--top];
+            if (e.near >= ray_t.max)
+                continue;
+
+            if (e.count > 0) {
+                for (uint32_t i = e.index; i < e.index + e.count; ++i) {
+                    RTW_COUNT(primitive_tests);
+                    if (primitives[i]->hit(r, ray_t, rec)) {
+                        hit_anything = true;
+                        ray_t.max = rec.t;
+                    }
+                }
+                continue;
+            }
+
+            const auto& node = wide[e.index];
+            RTW_ADD(box_tests, node.children);
+
+            lanes near(ray_t.min), far(ray_t.max);
+            for (int axis = 0; axis < 3; ++axis) {
+                int far_bound = near_bound[axis] < 3 ? axis + 3 : axis;
+                auto t_near = (lanes::load(node.bounds[near_bound[axis]]) - origin[axis]) * inv_dir[axis];
+                auto t_far = (lanes::load(node.bounds[far_bound]) - origin[axis]) * inv_dir[axis];
+                near = max(t_near, near);
+                far = min(t_far, far);
+            }
+            unsigned mask = (far > near).bits() & ((1u << node.children) - 1);
+            if (!mask)
+                continue;
+
+            // Order the children hit by decreasing distance and push them in that order.
+            real distance[N];
+            near.store(distance);
+            int order[N];
+            int hits = 0;
+            for (int k = 0; k < N; ++k) {
+                if (!(mask & (1u << k)))
+                    continue;
+                int j = hits++;
+                for (; j > 0 && distance[order[j - 1]] < distance[k]; --j)
+                    order[j] = order[j - 1];
+                order[j] = k;
+            }
+            for (int j = 0; j < hits; ++j) {
+                int k = order[j];
+                stack[top++] = {node.child[k], node.count[k], distance[k]};
+            }
+        }
+
+        return hit_anything;
     }
 
-    static bool box_y_compare(const shared_ptr<hittable>& a, const shared_ptr<hittable>& b) {
-        return box_compare(a, b, 1);
+    template <int N>
+    uint32_t collapse(uint32_t root, std::vector<wide_bvh_node<N>>& wide) {
+        // Appends the wide node that replaces the binary subtree of root, then the wide nodes
+        // of its subtrees. Its children are found by opening, from the children of root,
+        // the interior node with the largest surface area until there are N of them.
+        uint32_t children[N];
+        int n = 0;
+        if (nodes[root].count > 0) {
+            children[n++] = root;
+        } else {
+            children[n++] = root + 1;
+            children[n++] = nodes[root].offset;
+        }
+
+        while (n < N) {
+            int best = -1;
+            real best_area = -1;
+            for (int k = 0; k < n; ++k) {
+                const auto& child = nodes[children[k]];
+                if (child.count == 0 && child.box.surface_area() > best_area) {
+                    best = k;
+                    best_area = child.box.surface_area();
+                }
+            }
+            if (best < 0)
+                break;
+
+            uint32_t opened = children[best];
+            children[best] = opened + 1;
+            children[n++] = nodes[opened].offset;
+        }
+
+        auto index = static_cast<uint32_t>(wide.size());
+        wide.emplace_back();
+        wide[index].children = static_cast<uint8_t>(n);
+
+        for (int k = 0; k < N; ++k) {
+            // Unused slots get inverted bounds, +infinity below and -infinity above: the
+            // slab test then enters at +infinity and leaves at -infinity, a miss for any
+            // ray. The traversal also masks the slots by the child count.
+            for (int axis = 0; axis < 3; ++axis) {
+                wide[index].bounds[axis][k] = k < n ? nodes[children[k]].box.axis_interval(axis).min : +infinity;
+                wide[index].bounds[axis + 3][k] = k < n ? nodes[children[k]].box.axis_interval(axis).max : -infinity;
+            }
+            wide[index].child[k] = 0;
+            wide[index].count[k] = 0;
+        }
+
+        for (int k = 0; k < n; ++k) {
+            const auto& child = nodes[children[k]];
+            if (child.count > 0) {
+                wide[index].child[k] = child.offset;
+                wide[index].count[k] = child.count;
+            } else {
+                auto child_index = collapse(children[k], wide);
+                wide[index].child[k] = child_index;
+            }
+        }
+        return index;
     }
 
-    static bool box_z_compare(const shared_ptr<hittable>& a, const shared_ptr<hittable>& b) {
-        return box_compare(a, b, 2);
+    template <int N>
+    bvh_quality wide_quality(const std::vector<wide_bvh_node<N>>& wide, const bvh_build_options& costs) const {
+        // quality() of a wide BVH: a node costs one traversal step for all its children.
+        bvh_quality q;
+        q.bytes = wide.size() * sizeof(wide_bvh_node<N>) + primitives.size() * sizeof(const hittable*);
+        if (wide.empty())
+            return q;
+
+        double root_area = bbox.surface_area();
+        struct entry { uint32_t index; int depth; double area; };
+        std::vector<entry> stack = {{0, 1, root_area}};
+        while (!stack.empty()) {
+            auto [index, depth, area] = stack.back();
+            stack.pop_back();
+            const auto& node = wide[index];
+
+            q.nodes++;
+            q.max_depth = std::max(q.max_depth, depth);
+            q.sah_cost += (root_area > 0 ? area / root_area : 1) * costs.traversal_cost;
+            for (int k = 0; k < node.children; ++k) {
+                double extent[3];
+                for (int axis = 0; axis < 3; ++axis)
+                    extent[axis] = node.bounds[axis + 3][k] - node.bounds[axis][k];
+                double child_area = 2 * (extent[0] * extent[1] + extent[1] * extent[2] + extent[2] * extent[0]);
+
+                if (node.count[k] > 0) {
+                    q.leaves++;
+                    q.sah_cost += (root_area > 0 ? child_area / root_area : 1) * costs.intersection_cost * node.count[k];
+                } else {
+                    stack.push_back({node.child[k], depth + 1, child_area});
+                }
+            }
+        }
+        return q;
     }
 };
 #endif //RAYTRACINGINONEWEEKEND_BVH_H
@@ -16,9 +16,45 @@
 
 #include "rtweekend.h"
 
+#include "film.h"
+#include "framebuffer.h"
 #include "hittable.h"
 #include "pdf.h"
 #include "material.h"
+#include "tile_scheduler.h"
+
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+struct path_state {
+    // The state of one light path between bounces.
+    ray     r;              // The ray the path continues along
+    color   throughput;     // Product of the path weights so far
+    color   radiance;       // Light gathered by the path so far
+    int     depth;          // Bounces left before the path is cut off
+};
+
+struct wavefront_path {
+    // A path in flight in the wavefront integrator, with its own random stream so that it
+    // draws the same numbers as it would when traced on its own.
+    path_state  state;
+    pcg32       rng;
+};
+
+enum class render_engine {
+    path,       // Trace every sample's path to the end before the next one starts
+    wavefront,  // Trace a batch of paths together, one bounce per round, shaded by material
+};
 
 class camera {
 public:
@@ -36,37 +72,131 @@ public:
     double  defocus_angle   = 0;    // Variation angle of rays through each pixel
     double  focus_dist      = 10;   // Distance from camera lookfrom to plan of perfect focus
 
+    int     num_threads     = 0;    // Number of render threads (0 = all hardware threads)
+    int     tile_size       = 16;   // Edge length of the square tiles handed to the threads
+
+    bool     deterministic  = false;    // Key every sample's random stream by (pixel, sample)
+    uint64_t seed           = 0;        // Seed of the deterministic sample streams
+
+    int         samples_per_pass = 0;   // Samples per pixel in each progressive pass (0 = one pass)
+    std::string snapshot_path;          // If set, the image so far is written here after every pass
+                                        // (as PFM if it ends in .pfm, else as binary PPM)
+    std::function<void(int pass, int samples)> pass_callback;  // If set, called after every pass
+                                                               // with the samples per pixel so far
+
+    double  adaptive_threshold   = 0;   // Relative error at which a pixel stops sampling (0 = off)
+    int     adaptive_min_samples = 16;  // Samples every pixel takes before it may stop
+    int     adaptive_max_samples = 0;   // Per-pixel sample cap (0 = 4 * samples_per_pixel)
+    std::string sample_map_path;        // If set, a map of the samples every pixel took is written here
+
+    bool    russian_roulette = true;    // End low-throughput paths early without bias
+    int     rr_min_depth     = 5;       // Bounces a path always makes before Russian roulette
+    double  rr_max_survival  = 0.95;    // Upper clamp of the survival probability
+
+    render_engine engine = render_engine::path; // Integrator used to trace the samples
+    int     wavefront_batch_size = 4096;        // Paths in flight per wavefront batch
+    bool    packet_tracing = false;             // Trace the wavefront's camera rays in packets
+
+    // Format render writes to std::cout: ASCII P3 by default, which the README's capture
+    // commands expect; binary P6 and PFM are opt-in.
+    image_format output_format = image_format::ppm_ascii;
+
 
     // Render the world
     void render (const hittable& world, const hittable& lights) {
-        initialize();
+        auto image = render_image(world, lights);
+#ifdef _WIN32
+        // Binary formats must not have their newline bytes translated.
+        if (output_format != image_format::ppm_ascii)
+            _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        image.write(std::cout, output_format);
+        std::cout.flush();
+    }
 
-        // Render
+    // Render the world into an in-memory image.
+    framebuffer render_image(const hittable& world, const hittable& lights) {
+        return render_film(world, lights).resolve();
+    }
 
-        std::cout << "P3\n" << image_width << ' ' << image_height << "\n255\n";
+    // Render the world and return the accumulated samples, including how many samples
+    // every pixel took.
+    film render_film(const hittable& world, const hittable& lights) {
+        initialize();
 
-        for (int j = 0; j < image_height; j++) {
-            std::clog << "\rScanlines remaining: " << (image_height - j) << "\n"  << std::flush;
-            for (int i = 0; i < image_width; i++) {
-                color pixel_color(0, 0, 0);
-              for (int s_j = 0; s_j < sqrt_spp; ++s_j) {
-                for (int s_i = 0; s_i < sqrt_spp; ++s_i) {
-                  ray r = get_ray(i, j, s_i, s_j);
-                  pixel_color += ray_color(r, max_depth, world, lights);
-                }
-              }
-                write_color(std::cout, pixel_samples_scale*pixel_color);
-            }
+        // Render the samples in passes over the whole image, accumulating into the film.
+        // Every pass adds its samples to the running sums in sample index order, so the
+        // final image is the same whatever the pass size.
+        //
+        // With adaptive sampling, a pixel drops out of the later passes once the relative
+        // error of its mean is below adaptive_threshold. The samples it saves go to the
+        // noisy pixels, up to adaptive_max_samples each, until the budget of
+        // samples_per_pixel per pixel on average is spent.
+        film accum(image_width, image_height);
+        tile_scheduler scheduler(image_width, image_height, tile_size);
+
+        bool adaptive = adaptive_threshold > 0;
+        int pass_size = (samples_per_pass > 0) ? samples_per_pass
+                      : adaptive ? std::max(adaptive_min_samples, 1)
+                      : strata_count;
+        int max_samples = !adaptive ? strata_count
+                        : (adaptive_max_samples > 0) ? adaptive_max_samples
+                        : 4 * strata_count;
+        auto budget = static_cast<long long>(strata_count) * image_width * image_height;
+
+        auto tiles_total = static_cast<int>(scheduler.tile_count());
+        std::mutex log_lock;
+
+        for (int first_sample = 0, pass = 1; first_sample < max_samples; ++pass) {
+            int end_sample = std::min(first_sample + pass_size, max_samples);
+            std::atomic<int> tiles_done{0};
+            std::atomic<int> pixels_active{0};
+
+            // Decide which pixels take part in this pass before any of them changes.
+            auto active = active_pixels(accum);
+
+            scheduler.run(num_threads, [&](const tile& t) {
+                pixels_active += render_tile(t, first_sample, end_sample, world, lights,
+                                             active, accum);
+
+                int remaining = tiles_total - ++tiles_done;
+                std::lock_guard<std::mutex> guard(log_lock);
+                std::clog << "\rPass " << pass << ", samples " << end_sample
+                          << ", tiles remaining: " << remaining << ' ' << std::flush;
+            });
+
+            if (!snapshot_path.empty())
+                write_snapshot(accum.resolve());
+            if (pass_callback)
+                pass_callback(pass, end_sample);
+
+            first_sample = end_sample;
+            if (pixels_active == 0 || (adaptive && accum.total_samples() >= budget))
+                break;
         }
 
-        std::clog << "\rDone.                 \n";
+        std::clog << "\rDone.                                        \n";
+        if (adaptive)
+            std::clog << "Adaptive sampling: " << double(accum.total_samples()) / (image_width * image_height)
+                      << " samples per pixel on average\n";
+
+        if (!sample_map_path.empty()) {
+            std::ofstream out(sample_map_path);
+            if (out)
+                accum.write_sample_map(out);
+            else
+                std::cerr << "ERROR: Could not write sample map '" << sample_map_path << "'.\n";
+        }
+
+        return accum;
     }
 
 private:
     int     image_height{};           // Rendered image height
-    double  pixel_samples_scale{};    // Color scale factor for a sum of pixel samples
     int     sqrt_spp{};               // Square root of samples per pixel
     double  recip_sqrt_spp{};         // Reciprocal of the square root of samples per pixel: 1/sqrt_spp
+    int     strata_count{};           // Number of sub-pixel strata: sqrt_spp * sqrt_spp
+    int     stratum_stride{};         // Step between the strata of consecutive samples
     point3  center;                 // Camera center
     point3  pixel00_loc;            // Location of the upper left pixel
     vec3    pixel_delta_u;          // Horizontal delta vector from pixel to pixel
@@ -77,14 +207,241 @@ private:
 
 
 
+    int render_tile(const tile& t, int first_sample, int end_sample,
+                    const hittable& world, const hittable& lights,
+                    const std::vector<char>& active, film& accum) const {
+        // Render samples [first_sample, end_sample) of the active pixels of one tile, and
+        // return how many pixels took samples. Each tile and pass draws from its own PCG
+        // stream, so no two of them share a sample pattern, whichever thread renders them.
+        if (engine == render_engine::wavefront)
+            return render_tile_wavefront(t, first_sample, end_sample, world, lights, active, accum);
+
+        seed_random(mix_bits(pcg32::default_seed + first_sample), static_cast<uint64_t>(t.index));
+
+        int rendered = 0;
+        for (int j = t.y0; j < t.y1; j++) {
+            for (int i = t.x0; i < t.x1; i++) {
+                if (!active[static_cast<size_t>(j) * image_width + i])
+                    continue;
+                render_pixel(i, j, first_sample, end_sample, world, lights, accum);
+                ++rendered;
+            }
+        }
+        return rendered;
+    }
+
+    int render_tile_wavefront(const tile& t, int first_sample, int end_sample,
+                              const hittable& world, const hittable& lights,
+                              const std::vector<char>& active, film& accum) const {
+        // Wavefront version of render_tile. The samples of the tile's active pixels are
+        // traced in batches of about wavefront_batch_size paths. Every path is seeded from its
+        // (pixel, sample) key like a deterministic sample, so both engines render the same
+        // image, and the finished samples are added to the film in sample index order.
+        std::vector<std::pair<int, int>> pixels;
+        for (int j = t.y0; j < t.y1; j++)
+            for (int i = t.x0; i < t.x1; i++)
+                if (active[static_cast<size_t>(j) * image_width + i])
+                    pixels.emplace_back(i, j);
+
+        if (pixels.empty())
+            return 0;
+
+        auto pixel_count = static_cast<int>(pixels.size());
+        int samples_per_batch = std::max(1, wavefront_batch_size / pixel_count);
+        std::vector<wavefront_path> paths;
+        auto& rng = thread_rng();
+
+        for (int s0 = first_sample; s0 < end_sample; s0 += samples_per_batch) {
+            int s1 = std::min(s0 + samples_per_batch, end_sample);
+
+            // Generate the camera ray of every (pixel, sample) of the batch.
+            paths.clear();
+            for (const auto& [i, j] : pixels) {
+                auto pixel_index = static_cast<uint64_t>(j) * image_width + i;
+                for (int sample = s0; sample < s1; ++sample) {
+                    rng.seed_key(pixel_index ^ mix_bits(seed), static_cast<uint64_t>(sample));
+                    path_state state{get_ray(i, j, sample), color(1, 1, 1), color(0, 0, 0), max_depth};
+                    paths.push_back({state, rng});
+                }
+            }
+
+            trace_wavefront(paths, world, lights);
+
+            // Add the samples to the film in the order they were generated.
+            size_t k = 0;
+            for (const auto& [i, j] : pixels)
+                for (int sample = s0; sample < s1; ++sample)
+                    accum.add_sample(i, j, paths[k++].state.radiance);
+        }
+
+        return pixel_count;
+    }
+
+    void trace_wavefront(std::vector<wavefront_path>& paths,
+                         const hittable& world, const hittable& lights) const {
+        // Advance all paths one bounce per round. Each round first intersects every live path
+        // with the world, then sorts the hits by material type and shades each group in one
+        // loop, and the paths that go on form the queue of the next round.
+        std::vector<int> queue(paths.size());
+        std::iota(queue.begin(), queue.end(), 0);
+
+        std::vector<int> sorted, next;
+        std::vector<hit_record> hits(paths.size());
+        std::vector<unsigned char> types(paths.size());
+        std::vector<char> camera_hits;
+        auto& rng = thread_rng();
+
+        for (bool camera_rays = true; !queue.empty(); camera_rays = false) {
+            // Intersection: misses gather the background and leave the queue.
+            int type_counts[material_type_count] = {};
+            size_t hit_count = 0;
+
+            bool packets = camera_rays && packet_tracing;
+            if (packets)
+                intersect_packets(paths, world, hits, camera_hits);
+
+            for (int index : queue) {
+                auto& p = paths[index];
+                if (p.state.depth <= 0)
+                    continue;
+
+                bool hit;
+                if (packets) {
+                    hit = camera_hits[index];
+                } else {
+                    rng = p.rng;
+                    hit = world.hit(p.state.r, interval(0.001, infinity), hits[index]);
+                    p.rng = rng;
+                }
+
+                if (!hit) {
+                    p.state.radiance += p.state.throughput * background_color;
+                    continue;
+                }
+
+                auto type = static_cast<int>(material_table::global().type(hits[index].mat_id));
+                types[index] = static_cast<unsigned char>(type);
+                type_counts[type]++;
+                queue[hit_count++] = index;
+            }
+
+            // Counting sort of the hits by material type.
+            int offsets[material_type_count];
+            for (int type = 0, offset = 0; type < material_type_count; ++type) {
+                offsets[type] = offset;
+                offset += type_counts[type];
+            }
+
+            sorted.resize(hit_count);
+            for (size_t k = 0; k < hit_count; ++k) {
+                int index = queue[k];
+                sorted[offsets[types[index]]++] = index;
+            }
+
+            // Shading: one material type after the other; surviving paths go to the next round.
+            next.clear();
+            for (int index : sorted) {
+                auto& p = paths[index];
+                rng = p.rng;
+                if (shade(p.state, hits[index], lights))
+                    next.push_back(index);
+                p.rng = rng;
+            }
+
+            queue.swap(next);
+        }
+    }
+
+    static void intersect_packets(std::vector<wavefront_path>& paths, const hittable& world,
+                                  std::vector<hit_record>& hits, std::vector<char>& found) {
+        // Intersects the camera rays of the paths in packets of packet_width consecutive paths,
+        // i.e. of samples of the same or neighbouring pixels, which traverse the BVH together.
+        found.assign(paths.size(), 0);
+        ray_packet packet;
+
+        for (size_t first = 0; first < paths.size(); first += packet_width) {
+            auto end = std::min(first + packet_width, paths.size());
+
+            packet.clear();
+            for (auto k = first; k < end; ++k)
+                packet.add(paths[k].state.r, paths[k].rng);
+            packet.finalize();
+
+            auto mask = world.hit_packet(packet, packet.full_mask(), &hits[first]);
+            for (auto k = first; k < end; ++k) {
+                paths[k].rng = packet.rngs[k - first];
+                found[k] = (mask >> (k - first)) & 1u;
+            }
+        }
+    }
+
+    [[nodiscard]] std::vector<char> active_pixels(const film& accum) const {
+        // Returns which pixels still need samples. Without adaptive sampling that is all of
+        // them. Otherwise a pixel stops once it has its minimum samples and the relative error
+        // of every pixel in its 3x3 neighbourhood is below threshold. Looking at the neighbours
+        // keeps a pixel from stopping early just because its first samples happened to agree,
+        // e.g. when none of them found a small light.
+        std::vector<char> active(static_cast<size_t>(image_width) * image_height, 1);
+        if (adaptive_threshold <= 0)
+            return active;
+
+        for (int j = 0; j < image_height; j++) {
+            for (int i = 0; i < image_width; i++) {
+                if (accum.samples(i, j) < adaptive_min_samples)
+                    continue;
+
+                double error = 0;
+                for (int dj = std::max(j - 1, 0); dj <= std::min(j + 1, image_height - 1); dj++)
+                    for (int di = std::max(i - 1, 0); di <= std::min(i + 1, image_width - 1); di++)
+                        error = std::fmax(error, accum.relative_error(di, dj));
+
+                active[static_cast<size_t>(j) * image_width + i] = error >= adaptive_threshold;
+            }
+        }
+        return active;
+    }
+
+    void render_pixel(int i, int j, int first_sample, int end_sample,
+                      const hittable& world, const hittable& lights, film& accum) const {
+        // Add samples [first_sample, end_sample) of pixel i, j to the film, in sample index
+        // order. In deterministic mode every sample restarts the thread's generator from the
+        // (pixel, sample) key, so its value depends neither on the thread nor on the
+        // samples that ran before it.
+        auto pixel_index = static_cast<uint64_t>(j) * image_width + i;
+
+        for (int sample = first_sample; sample < end_sample; ++sample) {
+            if (deterministic)
+                thread_rng().seed_key(pixel_index ^ mix_bits(seed), static_cast<uint64_t>(sample));
+
+            ray r = get_ray(i, j, sample);
+            accum.add_sample(i, j, ray_color(r, max_depth, world, lights));
+        }
+    }
+
+    void write_snapshot(const framebuffer& image) const {
+        // Write the image so far, so that a long render can be inspected or stopped early.
+        std::ofstream out(snapshot_path, std::ios::binary);
+        if (!out) {
+            std::cerr << "ERROR: Could not write snapshot '" << snapshot_path << "'.\n";
+            return;
+        }
+        image.write(out, image_format_for(snapshot_path));
+    }
+
     // Initialize the camera.
     void  initialize() {
         image_height = int (image_width / aspect_ratio);
         image_height = (image_height < 1) ? 1 : image_height;
 
         sqrt_spp = int(std::sqrt(samples_per_pixel));
-        pixel_samples_scale = 1.0 / (sqrt_spp * sqrt_spp);
         recip_sqrt_spp = 1.0 / sqrt_spp;
+        strata_count = sqrt_spp * sqrt_spp;
+
+        // Visit the strata with a stride near strata_count / golden ratio that is coprime to
+        // strata_count, so that the samples of an early pass are spread over the whole pixel.
+        stratum_stride = std::max(1, int(0.618034 * strata_count));
+        while (std::gcd(stratum_stride, strata_count) != 1)
+            ++stratum_stride;
 
         center = lookfrom;
 
@@ -119,12 +476,13 @@ private:
         defocus_disk_v = defocus_radius * v;
     }
 
-    [[nodiscard]] ray get_ray(int i, int j, int s_i, int s_j) const {
+    [[nodiscard]] ray get_ray(int i, int j, int sample) const {
         // Construct a camera ray origination from the defocus disk and directed at
-        // a randomly sampled point around the pixel location i, j for stratified
-        // sample square s_i, s_j.
+        // a randomly sampled point around the pixel location i, j, inside the
+        // stratified sample square of the given sample index.
 
-        auto offset = sample_square_stratified(s_i, s_j);
+        auto stratum = static_cast<int>((static_cast<int64_t>(sample) * stratum_stride) % strata_count);
+        auto offset = sample_square_stratified(stratum % sqrt_spp, stratum / sqrt_spp);
         auto pixel_sample = pixel00_loc
                 + ((i + offset.x()) * pixel_delta_u)
                 + ((j + offset.y()) * pixel_delta_v);
@@ -133,7 +491,7 @@ private:
         auto ray_direction   = unit_vector(pixel_sample - ray_origin);
         auto ray_time       = random_double();
 
-        return {ray_origin, ray_direction, ray_time};
+        return ray(ray_origin, ray_direction, ray_time);
     }
 
     [[nodiscard]] vec3 sample_square_stratified(int s_i, int s_j) const {
@@ -143,12 +501,12 @@ private:
         auto px = ((s_i + random_double()) * recip_sqrt_spp) - 0.5;
         auto py = ((s_j + random_double()) * recip_sqrt_spp) - 0.5;
 
-        return {px, py, 0};
+        return vec3(px, py, 0);
     }
 
     [[nodiscard]] vec3 sample_square() const {
         // Returns the vector to a random point in the [-.5, -.5] - [+.5, +.5] unit square.
-        return {random_double() - 0.5, random_double() - 0.5, 0};
+        return vec3(random_double() - 0.5, random_double() - 0.5, 0);
     }
 
     [[nodiscard]] point3 defocus_disk_sample() const {
@@ -157,60 +515,98 @@ private:
         return center + (p[0] * defocus_disk_u) + (p[1] * defocus_disk_v);
     }
 
+    [[nodiscard]] double survival_probability(const color& throughput, int depth) const {
+      // Russian roulette: once a path has made rr_min_depth bounces, it continues with a
+      // probability that follows its throughput, clamped to rr_max_survival. Paths that can
+      // only add little light end early, and dividing the survivors by this probability
+      // keeps the estimate unbiased.
+      int bounces = max_depth - depth;
+      if (!russian_roulette || bounces < rr_min_depth)
+        return 1.0;
+
+      auto max_component = std::fmax(throughput.x(), std::fmax(throughput.y(), throughput.z()));
+      return std::fmin(max_component, rr_max_survival);
+    }
+
     [[nodiscard]] color ray_color(
       const ray& r, int depth, const hittable& world, const hittable& lights) const {
       // The ray_color function takes a ray as an argument and returns a color.
+      // It follows the path one bounce at a time, keeping the throughput and the gathered
+      // radiance in a path_state instead of recursing once per bounce.
+      path_state path{r, color(1, 1, 1), color(0, 0, 0), depth};
+      hit_record rec;
 
-      // If we've exceeded the ray bounce limit, no more light is gathered.
-      if (depth <= 0)
-            return {0, 0, 0};
+      // Each loop iteration is one bounce, until the path escapes, is absorbed, is ended by
+      // Russian roulette or reaches the bounce limit.
+      while (path.depth > 0) {
+        // If the ray hits nothing, gather the background color.
+        if (!world.hit(path.r, interval(0.001, infinity), rec)) {
+          path.radiance += path.throughput * background_color;
+          break;
+        }
 
-      hit_record rec;
+        if (!shade(path, rec, lights))
+          break;
+      }
+
+      return path.radiance;
+    }
 
-      // If the ray hits nothing, return the background color.
-      if (!world.hit(r, interval(0.001, infinity), rec))
-          return background_color;
+    bool shade(path_state& path, const hit_record& rec, const hittable& lights) const {
+      // Gather the light emitted at the hit point, then sample the next ray of the path.
+      // Returns false if the path ends here.
+      const ray& r = path.r;
+      const auto& materials = material_table::global();
 
       // Create a scatter record to store scattering information
       scatter_record srec;
 
       // Get the emitted color from the material at the hit point
-      color color_from_emission = rec.mat->emitted(r, rec, rec.u, rec.v, rec.p);
-
-      // If the material does not scatter the ray, return the emitted color
-      if (!rec.mat->scatter(r, rec, srec))
-        return color_from_emission;
-
-      // If the PDF should be skipped, recursively get the color from the scattered ray
-      // using the precomputed scattered ray in the scatter record.
-      if (srec.skip_pdf)
-        return srec.attenuation * ray_color(srec.skip_pdf_ray, depth - 1, world, lights);
-
-      // Create a PDF for sampling light sources
-      auto light_ptr =
-          make_shared<hittable_pdf>(lights, rec.p);
-
-      // Combine the light source PDF with the material's scattering PDF
-      mixture_pdf p(light_ptr, srec.pdf_ptr);
-
-      // Generate a scattered ray using the combined PDF
-      ray scattered = ray(rec.p, p.generate(), r.time());
-
-      // Calculate the PDF value for the scattered direction
-      auto pdf_value = p.value(scattered.direction());
-
-      // Calculate the scattering PDF value for the scattered direction
-      double scattering_pdf = rec.mat->scattering_pdf(r, rec, scattered);
-
-      // Recursively get the color from the scattered ray
-      color sample_color = ray_color(scattered, depth - 1, world, lights);
-
-      // Calculate the color contribution from scattering
-      color color_from_scatter =
-          (srec.attenuation * scattering_pdf * sample_color) / pdf_value;
-
-      // If the ray is scattered, return the scattered ray color and the emitted light.
-      return color_from_emission + color_from_scatter;
+      path.radiance += path.throughput * materials.emitted(rec.mat_id, r, rec, rec.u, rec.v, rec.p);
+
+      // If the material does not scatter the ray, the path ends with the emitted color
+      if (!materials.scatter(rec.mat_id, r, rec, srec))
+        return false;
+
+      color weight;
+      ray scattered;
+
+      if (srec.skip_pdf) {
+        // If the PDF should be skipped, follow the precomputed scattered ray
+        // in the scatter record.
+        weight = srec.attenuation;
+        scattered = srec.skip_pdf_ray;
+      } else {
+        // Create a PDF for sampling light sources
+        hittable_pdf light_pdf(lights, rec.p);
+
+        // Combine the light source PDF with the material's scattering PDF
+        mixture_pdf p(light_pdf, srec.surface_pdf);
+
+        // Generate a scattered ray using the combined PDF
+        scattered = ray(rec.p, p.generate(), r.time());
+
+        // Calculate the PDF value for the scattered direction
+        auto pdf_value = p.value(scattered.direction());
+
+        // Calculate the scattering PDF value for the scattered direction
+        double scattering_pdf = materials.scattering_pdf(rec.mat_id, r, rec, scattered);
+
+        // Weight of the scattered path: attenuation * scattering pdf / sampling pdf
+        weight = (srec.attenuation * scattering_pdf) / pdf_value;
+      }
+
+      // Decide whether the path survives Russian roulette
+      auto survival = survival_probability(path.throughput * weight, path.depth);
+      if (survival < 1.0 && random_double() >= survival)
+        return false;
+
+      // Continue the path along the scattered ray.
+      path.throughput *= weight / survival;
+      path.r = ray(offset_ray_origin(scattered.origin(), rec.normal, scattered.direction()),
+                   scattered.direction(), scattered.time());
+      path.depth--;
+      return true;
     }
 };
 #endif //RAYTRACINGINONEWEEKEND_CAMERA_H
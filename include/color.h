@@ -19,6 +19,13 @@
 #include "interval.h"
 #include "vec3.h"
 
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RTW_HAVE_SSE2 1
+#endif
+
 using color = vec3;
 
 // Converts linear RGB color component to gamma-corrected component using gamma 2.0
@@ -57,4 +64,47 @@ void write_color(std::ostream &out, const color& pixel_color) {
     out << rbyte << ' ' << gbyte << ' ' << bbyte << '\n';
 }
 
+#ifdef RTW_HAVE_SSE2
+// Loads two color components as doubles.
+inline __m128d load_components(const double* p) { return _mm_loadu_pd(p); }
+inline __m128d load_components(const float* p) {
+    return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))));
+}
+#endif
+
+// Converts linear color components to gamma-corrected 8-bit values, exactly as write_color
+// does: NaN and non-positive components become 0, the rest is gamma corrected, clamped to
+// [0,0.999] and scaled to [0,255]. Four components are converted per step with SSE2.
+template <typename T>
+inline void quantize_components(const T* linear, size_t count, unsigned char* bytes) {
+    size_t k = 0;
+
+#ifdef RTW_HAVE_SSE2
+    const __m128d zero  = _mm_setzero_pd();
+    const __m128d top   = _mm_set1_pd(0.999);
+    const __m128d scale = _mm_set1_pd(256.0);
+
+    auto quantize2 = [&](__m128d x) {
+        x = _mm_and_pd(x, _mm_cmpgt_pd(x, zero));  // NaN and x <= 0 compare false: zero them
+        x = _mm_min_pd(_mm_sqrt_pd(x), top);
+        return _mm_cvttpd_epi32(_mm_mul_pd(x, scale));
+    };
+
+    for (; k + 4 <= count; k += 4) {
+        __m128i lo = quantize2(load_components(linear + k));
+        __m128i hi = quantize2(load_components(linear + k + 2));
+        __m128i words = _mm_packs_epi32(_mm_unpacklo_epi64(lo, hi), _mm_setzero_si128());
+        auto packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+        std::memcpy(bytes + k, &packed, 4);
+    }
+#endif
+
+    static const basic_interval<double> intensity(0.000, 0.999);
+    for (; k < count; ++k) {
+        double x = linear[k];
+        if (x != x) x = 0.0;
+        bytes[k] = static_cast<unsigned char>(int(256 * intensity.clamp(linear_to_gamma(x))));
+    }
+}
+
 #endif //RAYTRACINGINONEWEEKEND_COLOR_H
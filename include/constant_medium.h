@@ -23,11 +23,11 @@
 class constant_medium : public hittable {
   // The constant_medium class represents a volume of constant density.
  public:
-  constant_medium(shared_ptr<hittable> boundary, double density, const shared_ptr<texture>& tex)
+  constant_medium(shared_ptr<hittable> boundary, real density, const shared_ptr<texture>& tex)
       : boundary(std::move(boundary)), neg_inv_density(-1/density),
         phase_function(make_shared<isotropic>(tex)) {}
 
-  constant_medium(shared_ptr<hittable> boundary, double density, const color& albedo)
+  constant_medium(shared_ptr<hittable> boundary, real density, const color& albedo)
       : boundary(std::move(boundary)), neg_inv_density(-1/density),
         phase_function(make_shared<isotropic>(albedo)) {}
 
@@ -67,7 +67,7 @@ class constant_medium : public hittable {
 
     rec.normal = vec3(1, 0, 0);  // Arbitrary
     rec.front_face = true;        // also arbitrary
-    rec.mat = phase_function;
+    rec.mat_id = phase_function->id();
 
     return true;
   }
@@ -78,7 +78,7 @@ class constant_medium : public hittable {
 
  private:
   shared_ptr<hittable> boundary; // The boundary of the volume.
-  double neg_inv_density; // The negative inverse density of the volume.
+  real neg_inv_density; // The negative inverse density of the volume.
   shared_ptr<material> phase_function; // The phase function of the volume.
 };
 #endif //RAYTRACINGINONEWEEKEND_INCLUDE_CONSTANT_MEDIUM_H_
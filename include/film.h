@@ -0,0 +1,121 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: film.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: The film class accumulates the samples of a progressive render. It keeps the
+ * running sum and the sample count of every pixel, so that further passes can be added to
+ * it and the image so far can be resolved at any time.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_FILM_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_FILM_H_
+
+#include "rtweekend.h"
+
+#include "framebuffer.h"
+
+#include <vector>
+
+class film {
+ public:
+  film() = default;
+
+  film(int width, int height)
+      : image_width(width), image_height(height),
+        sums(static_cast<size_t>(width) * height),
+        counts(static_cast<size_t>(width) * height, 0),
+        lum_means(static_cast<size_t>(width) * height, 0.0),
+        lum_m2s(static_cast<size_t>(width) * height, 0.0) {}
+
+  [[nodiscard]] int width() const { return image_width; }
+  [[nodiscard]] int height() const { return image_height; }
+
+  // Every pixel is owned by exactly one tile, so concurrent writers never touch the same element.
+  void add_sample(int i, int j, const color& sample) {
+    // Add one sample to the pixel sum and update the luminance statistics.
+    auto k = index(i, j);
+    sums[k] += sample;
+
+    auto n = ++counts[k];
+    auto lum = luminance(sample);
+    auto delta = lum - lum_means[k];
+    lum_means[k] += delta / n;
+    lum_m2s[k] += delta * (lum - lum_means[k]);
+  }
+
+  [[nodiscard]] const color& sum(int i, int j) const { return sums[index(i, j)]; }
+  [[nodiscard]] int samples(int i, int j) const { return counts[index(i, j)]; }
+
+  [[nodiscard]] double relative_error(int i, int j) const {
+    // Returns the standard error of the pixel's mean luminance relative to the mean.
+    // Dark pixels are measured against a floor of 0.05, below which noise is hard to see.
+    auto k = index(i, j);
+    auto n = counts[k];
+    if (n < 2)
+      return infinity;
+
+    auto variance = lum_m2s[k] / (n - 1);
+    return std::sqrt(variance / n) / std::fmax(lum_means[k], 0.05);
+  }
+
+  [[nodiscard]] long long total_samples() const {
+    long long total = 0;
+    for (auto n : counts)
+      total += n;
+    return total;
+  }
+
+  void write_sample_map(std::ostream& out) const {
+    // Writes how many samples every pixel took as an ASCII PGM (P2) image, scaled so that
+    // the pixel with the most samples is white.
+    int max_count = 1;
+    for (auto n : counts)
+      max_count = std::max(max_count, n);
+
+    out << "P2\n" << image_width << ' ' << image_height << "\n255\n";
+    for (auto n : counts)
+      out << (255 * n) / max_count << '\n';
+  }
+
+  [[nodiscard]] framebuffer resolve() const {
+    // Returns the mean of the samples taken so far for every pixel.
+    framebuffer image(image_width, image_height);
+
+    for (int j = 0; j < image_height; ++j) {
+      for (int i = 0; i < image_width; ++i) {
+        auto n = samples(i, j);
+        image.at(i, j) = n > 0 ? (1.0 / n) * sum(i, j) : color(0, 0, 0);
+      }
+    }
+
+    return image;
+  }
+
+ private:
+  int                 image_width  = 0;  // Image width in pixels
+  int                 image_height = 0;  // Image height in pixels
+  std::vector<color>  sums;              // Running sum of the samples of every pixel
+  std::vector<int>    counts;            // Number of samples in every sum
+  std::vector<double> lum_means;         // Running mean of every pixel's luminance
+  std::vector<double> lum_m2s;           // Running sum of squared luminance deviations
+
+  static double luminance(const color& c) {
+    // Luminance of the sample as it will be displayed: clamped and gamma corrected, so
+    // that the noise of over-exposed pixels (e.g. light edges) does not attract samples.
+    static const interval intensity(0.000, 0.999);
+    return 0.2126 * intensity.clamp(linear_to_gamma(c.x()))
+         + 0.7152 * intensity.clamp(linear_to_gamma(c.y()))
+         + 0.0722 * intensity.clamp(linear_to_gamma(c.z()));
+  }
+
+  [[nodiscard]] size_t index(int i, int j) const {
+    return static_cast<size_t>(j) * image_width + i;
+  }
+};
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_FILM_H_
@@ -0,0 +1,520 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: flat_bvh.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: The build and traversal of a flat binary BVH, shared by bvh_node (whose leaves
+ * hold hittables) and triangle_mesh (whose leaves hold triangles). The tree is built over
+ * records of the primitives' boxes and centroids, split at the object median, with the
+ * surface area heuristic (SAH) over a fixed number of bins per axis, or at the Morton code
+ * bits of a linear BVH (LBVH), and stored in one array in depth-first order: the first child
+ * of an interior node is the next node, and only the second child needs an offset. What a
+ * leaf holds, and how a ray tests the primitives of a leaf, are up to the tree's owner.
+ * Large builds run on several threads: the records, Morton codes and sort are computed in
+ * chunks, and the two halves of every large span are built in parallel into separate trees
+ * that are then joined, so the tree is the same for any thread count.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_FLAT_BVH_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_FLAT_BVH_H_
+
+#include "rtweekend.h"
+
+#include "AABB.h"
+#include "stats.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+enum class bvh_split {
+  median,  // Split at the object median along the longest axis
+  sah,     // Split where the surface area heuristic is lowest
+  lbvh     // Split at the highest differing bit of the centroids' Morton codes
+};
+
+struct bvh_build_options {
+  bvh_split split             = bvh_split::sah;
+  int       max_leaf_size     = 4;      // Most primitives in a leaf
+  int       sah_bins          = 16;     // Bins per axis; their boundaries are the candidate splits
+  int       width             = 2;      // Children per node: 2, or 4 or 8 for a wide BVH
+  int       threads           = 0;      // Threads of the build; 0 uses all hardware threads
+  double    traversal_cost    = 0.125;  // Cost of visiting a node, relative to...
+  double    intersection_cost = 1.0;    // ...the cost of testing one primitive
+  bool      motion_blur       = true;   // Interpolate the bounds of moving objects at ray times
+  int       motion_segments   = 0;      // Time segments of a motion BVH; 0 picks them (or none)
+};
+
+struct alignas(32) linear_bvh_node {
+  // A node of the flattened BVH: 32 bytes with float bounds, 64 (a cache line) with double.
+  AABB     box;
+  uint32_t offset;  // Interior nodes: index of the second child. Leaves: first primitive
+  uint16_t count;   // Number of primitives of a leaf; 0 for interior nodes
+  uint8_t  axis;    // Axis the node was split along; the first child is on its low side
+};
+
+struct bvh_build_primitive {
+  // The record of a primitive the builders move around instead of the primitive itself.
+  AABB     box;
+  point3   centroid;
+  size_t   index;   // Index of the primitive in the source list
+  uint64_t morton;  // Morton code of the centroid (LBVH builds only)
+};
+
+template <typename Leaf>
+struct flat_bvh {
+  // The nodes, their motion bounds (only if the primitives move) and the leaf primitives of
+  // a tree; every leaf is a range of the primitives.
+  std::vector<linear_bvh_node> nodes;
+  std::vector<motion_box>      motion;
+  std::vector<Leaf>            primitives;
+};
+
+// Deepest tree a traversal stack has to hold. The builder splits spans in balanced halves
+// once it gets within 32 levels of this, which keeps any span of up to 2^32 primitives
+// inside the limit.
+constexpr int bvh_max_depth = 64;
+
+// Smallest span of primitives that is worth handing to another thread.
+constexpr size_t parallel_span = 8192;
+
+inline int build_threads(const bvh_build_options& options) {
+  // The threads a build uses.
+  return options.threads > 0 ? options.threads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+inline size_t parallel_chunk_count(size_t count, int threads) {
+  // Number of chunks parallel_for splits count items into.
+  return std::max<size_t>(1, std::min<size_t>(threads, count / parallel_span));
+}
+
+template <typename F>
+void parallel_chunks(size_t chunks, const F& body) {
+  // Calls body(c) for every chunk c in [0, chunks), each on its own thread.
+  std::vector<std::thread> workers;
+  workers.reserve(chunks > 0 ? chunks - 1 : 0);
+  for (size_t c = 1; c < chunks; ++c)
+    workers.emplace_back([&body, c] { body(c); });
+  if (chunks > 0)
+    body(0);
+  for (auto& worker : workers)
+    worker.join();
+}
+
+template <typename F>
+void parallel_for(size_t count, int threads, const F& body) {
+  // Calls body(begin, end) on consecutive chunks of [0, count), one chunk per thread.
+  size_t chunks = parallel_chunk_count(count, threads);
+  parallel_chunks(chunks, [&](size_t c) { body(c * count / chunks, (c + 1) * count / chunks); });
+}
+
+inline uint64_t morton_expand_bits(uint64_t v) {
+  // Spreads the low 21 bits of v out to every third bit.
+  v &= 0x1fffff;
+  v = (v | v << 32) & 0x1f00000000ffff;
+  v = (v | v << 16) & 0x1f0000ff0000ff;
+  v = (v | v << 8) & 0x100f00f00f00f00f;
+  v = (v | v << 4) & 0x10c30c30c30c30c3;
+  v = (v | v << 2) & 0x1249249249249249;
+  return v;
+}
+
+inline void sort_by_morton_code(std::vector<bvh_build_primitive>& prims, int threads) {
+  // Gives every primitive the 63-bit Morton code of its centroid, quantized to 2^21 steps
+  // per axis of a cube around the centroid bounds, and sorts the primitives by code. (With a
+  // step per axis of the bounds themselves, the short axis of a flat scene would get as many
+  // splits as the long ones.) The codes and indices are sorted alone, with a parallel LSD
+  // radix sort (stable, so equal codes stay in source order), and the records are then
+  // gathered in that order.
+  interval bounds[3] = {interval::empty, interval::empty, interval::empty};
+  for (const auto& p : prims)
+    for (int axis = 0; axis < 3; ++axis)
+      bounds[axis] = interval(bounds[axis], interval(p.centroid[axis], p.centroid[axis]));
+
+  double extent = std::max({bounds[0].size(), bounds[1].size(), bounds[2].size()});
+
+  struct keyed { uint64_t code; size_t index; };
+  size_t count = prims.size();
+  std::vector<keyed> keys(count), sorted(count);
+
+  parallel_for(count, threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      uint64_t code = 0;
+      for (int axis = 0; axis < 3; ++axis) {
+        double u = extent > 0 ? (prims[i].centroid[axis] - bounds[axis].min) / extent : 0;
+        auto q = static_cast<uint64_t>(std::clamp(u * 2097152.0, 0.0, 2097151.0));
+        code |= morton_expand_bits(q) << (2 - axis);
+      }
+      keys[i] = {code, i};
+    }
+  });
+
+  // Six passes of 11-bit digits. Every chunk counts its digits, the counts are turned into
+  // the position of every (digit, chunk) run, and the chunks scatter in parallel.
+  constexpr int digit_bits = 11;
+  constexpr size_t digits = size_t(1) << digit_bits;
+  size_t chunks = parallel_chunk_count(count, threads);
+  std::vector<std::vector<size_t>> offsets(chunks, std::vector<size_t>(digits));
+  auto chunk_begin = [&](size_t c) { return c * count / chunks; };
+
+  for (int shift = 0; shift < 63; shift += digit_bits) {
+    parallel_chunks(chunks, [&](size_t c) {
+      std::fill(offsets[c].begin(), offsets[c].end(), 0);
+      for (size_t i = chunk_begin(c); i < chunk_begin(c + 1); ++i)
+        offsets[c][keys[i].code >> shift & (digits - 1)]++;
+    });
+
+    size_t position = 0;
+    for (size_t d = 0; d < digits; ++d)
+      for (size_t c = 0; c < chunks; ++c) {
+        size_t n = offsets[c][d];
+        offsets[c][d] = position;
+        position += n;
+      }
+
+    parallel_chunks(chunks, [&](size_t c) {
+      for (size_t i = chunk_begin(c); i < chunk_begin(c + 1); ++i)
+        sorted[offsets[c][keys[i].code >> shift & (digits - 1)]++] = keys[i];
+    });
+    keys.swap(sorted);
+  }
+
+  std::vector<bvh_build_primitive> gathered(count);
+  parallel_for(count, threads, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      gathered[i] = prims[keys[i].index];
+      gathered[i].morton = keys[i].code;
+    }
+  });
+  prims.swap(gathered);
+}
+
+inline int sah_bin_index(real c, const interval& extent, int bin_count) {
+  // The bin of a centroid coordinate within the centroid extent.
+  auto k = static_cast<int>(bin_count * ((c - extent.min) / extent.size()));
+  return std::clamp(k, 0, bin_count - 1);
+}
+
+inline size_t median_split(std::vector<bvh_build_primitive>& prims, size_t start, size_t end,
+                           const AABB& bbox, const bvh_build_options& options, int& split_axis) {
+  // Split at the object median of the box minimums along the longest axis.
+  // Returns start to make a leaf, and sets split_axis otherwise (as do the others).
+  if (end - start <= static_cast<size_t>(std::max(options.max_leaf_size, 1)))
+    return start;
+
+  int axis = split_axis = bbox.longest_axis();
+  auto mid = start + (end - start) / 2;
+  std::nth_element(prims.begin() + start, prims.begin() + mid, prims.begin() + end,
+                   [axis](const bvh_build_primitive& a, const bvh_build_primitive& b) {
+                     return a.box.axis_interval(axis).min < b.box.axis_interval(axis).min;
+                   });
+  return mid;
+}
+
+inline size_t sah_split(std::vector<bvh_build_primitive>& prims, size_t start, size_t end,
+                        const AABB& bbox, const bvh_build_options& options, int& split_axis) {
+  // Bins the centroids along every axis and picks the bin boundary with the lowest SAH
+  // cost. Returns start to make a leaf, when that is cheaper than any split and the span
+  // fits in a leaf.
+  size_t count = end - start;
+  auto max_leaf = static_cast<size_t>(std::max(options.max_leaf_size, 1));
+  if (count <= 1)
+    return start;
+
+  // Bounds of the centroids (unpadded, unlike an AABB).
+  interval centroid_bounds[3] = {interval::empty, interval::empty, interval::empty};
+  for (size_t i = start; i < end; i++)
+    for (int axis = 0; axis < 3; ++axis)
+      centroid_bounds[axis] = interval(centroid_bounds[axis],
+                                       interval(prims[i].centroid[axis], prims[i].centroid[axis]));
+
+  struct bin {
+    AABB box = AABB::empty;
+    int  count = 0;
+  };
+
+  int bin_count = std::max(options.sah_bins, 2);
+  std::vector<bin> bins(bin_count);
+  std::vector<double> right_area(bin_count);
+  std::vector<int> right_count(bin_count);
+
+  double best_cost = infinity;
+  int best_axis = -1, best_bin = 0;
+  double node_area = bbox.surface_area();
+
+  for (int axis = 0; axis < 3; ++axis) {
+    const interval& extent = centroid_bounds[axis];
+    if (!(extent.size() > 0))
+      continue;
+
+    std::fill(bins.begin(), bins.end(), bin{});
+    for (size_t i = start; i < end; i++) {
+      auto& b = bins[sah_bin_index(prims[i].centroid[axis], extent, bin_count)];
+      b.box = AABB(b.box, prims[i].box);
+      b.count++;
+    }
+
+    // Sweep from the right to get the area and count right of every boundary...
+    AABB box = AABB::empty;
+    int n = 0;
+    for (int k = bin_count - 1; k > 0; --k) {
+      box = AABB(box, bins[k].box);
+      n += bins[k].count;
+      right_area[k] = n ? box.surface_area() : 0;
+      right_count[k] = n;
+    }
+
+    // ...then from the left, evaluating the split after every bin.
+    box = AABB::empty;
+    n = 0;
+    for (int k = 0; k < bin_count - 1; ++k) {
+      box = AABB(box, bins[k].box);
+      n += bins[k].count;
+      if (n == 0 || right_count[k + 1] == 0)
+        continue;
+
+      double cost = options.traversal_cost
+                  + options.intersection_cost
+                    * (box.surface_area() * n + right_area[k + 1] * right_count[k + 1])
+                    / node_area;
+      if (cost < best_cost) {
+        best_cost = cost;
+        best_axis = axis;
+        best_bin = k;
+      }
+    }
+  }
+
+  double leaf_cost = options.intersection_cost * count;
+  if (count <= max_leaf && leaf_cost <= best_cost)
+    return start;
+
+  if (best_axis < 0) {
+    // Every centroid is the same point: no plane separates them, so split the span in
+    // halves (or keep it as one leaf if it fits).
+    return count <= max_leaf ? start : start + count / 2;
+  }
+
+  split_axis = best_axis;
+  const interval& extent = centroid_bounds[best_axis];
+  auto split = std::partition(prims.begin() + start, prims.begin() + end,
+                              [&](const bvh_build_primitive& p) {
+                                return sah_bin_index(p.centroid[best_axis], extent, bin_count) <= best_bin;
+                              });
+  return static_cast<size_t>(split - prims.begin());
+}
+
+inline size_t lbvh_split(std::vector<bvh_build_primitive>& prims, size_t start, size_t end,
+                         const bvh_build_options& options, int& split_axis) {
+  // The span is sorted by Morton code, so all its codes share the bits above the highest
+  // bit where its first and last codes differ; split where that bit turns on.
+  // Returns start to make a leaf.
+  size_t count = end - start;
+  if (count <= static_cast<size_t>(std::max(options.max_leaf_size, 1)))
+    return start;
+
+  uint64_t difference = prims[start].morton ^ prims[end - 1].morton;
+  if (difference == 0)
+    return start + count / 2;
+
+  int bit = 63;
+  while (!(difference >> bit & 1))
+    --bit;
+  split_axis = 2 - bit % 3;
+  auto split = std::partition_point(prims.begin() + start, prims.begin() + end,
+                                    [bit](const bvh_build_primitive& p) { return !(p.morton >> bit & 1); });
+  return static_cast<size_t>(split - prims.begin());
+}
+
+template <typename Leaf, typename LeafOf>
+class flat_bvh_builder {
+ public:
+  // leaf_of(index) is what a leaf holds for the primitive with the given source index.
+  // object_motion, if not empty, holds the bounds of every primitive at both ends of the
+  // shutter, and the tree gets the motion bounds of its nodes. Spans of at most leaf_span
+  // primitives are always leaves.
+  flat_bvh_builder(const bvh_build_options& options, const LeafOf& leaf_of,
+                   const std::vector<motion_box>& object_motion, size_t leaf_span)
+      : options(options), leaf_of(leaf_of), object_motion(object_motion), leaf_span(std::max<size_t>(leaf_span, 1)) {}
+
+  void build(std::vector<bvh_build_primitive>& prims, size_t start, size_t end, int depth,
+             flat_bvh<Leaf>& tree, int threads) const {
+    // Appends the node of the span and then its subtree to the tree, using up to the given
+    // number of threads.
+
+    // Morton splits do not look at the box of the span. Their nodes get the union of the
+    // boxes of their children instead, once those are built, which saves a pass over the
+    // span per level.
+    bool bottom_up = options.split == bvh_split::lbvh;
+    AABB box = AABB::empty;
+    if (!bottom_up)
+      for (size_t i = start; i < end; i++)
+        box = AABB(box, prims[i].box);
+
+    auto index = static_cast<uint32_t>(tree.nodes.size());
+    tree.nodes.push_back({box, 0, 0, 0});
+    bool moving = !object_motion.empty();
+    if (moving)
+      tree.motion.emplace_back(AABB::empty, AABB::empty);
+
+    size_t span = end - start;
+    size_t mid;
+    int axis = 0;
+    if (span <= leaf_span)
+      mid = start;
+    else if (depth >= bvh_max_depth - 32)
+      mid = span <= static_cast<size_t>(std::max(options.max_leaf_size, 1)) ? start : start + span / 2;
+    else if (options.split == bvh_split::sah)
+      mid = sah_split(prims, start, end, box, options, axis);
+    else if (options.split == bvh_split::lbvh)
+      mid = lbvh_split(prims, start, end, options, axis);
+    else
+      mid = median_split(prims, start, end, box, options, axis);
+
+    // Leaves are limited by the width of the count; larger spans are split.
+    if ((mid == start || mid == end) && span > UINT16_MAX)
+      mid = start + span / 2;
+
+    if (mid == start || mid == end) {
+      // Leaf: keep the primitives of the span in the order of the source list.
+      std::sort(prims.begin() + start, prims.begin() + end,
+                [](const bvh_build_primitive& a, const bvh_build_primitive& b) { return a.index < b.index; });
+      tree.nodes[index].offset = static_cast<uint32_t>(tree.primitives.size());
+      tree.nodes[index].count = static_cast<uint16_t>(span);
+      for (size_t i = start; i < end; i++) {
+        tree.primitives.push_back(leaf_of(prims[i].index));
+        if (bottom_up)
+          tree.nodes[index].box = AABB(tree.nodes[index].box, prims[i].box);
+        if (moving)
+          tree.motion[index] = motion_box(tree.motion[index], object_motion[prims[i].index]);
+      }
+      return;
+    }
+
+    tree.nodes[index].axis = static_cast<uint8_t>(axis);
+    build_children(prims, index, start, mid, end, depth, tree, threads);
+
+    if (bottom_up)
+      tree.nodes[index].box = AABB(tree.nodes[index + 1].box, tree.nodes[tree.nodes[index].offset].box);
+    if (moving)
+      tree.motion[index] = motion_box(tree.motion[index + 1], tree.motion[tree.nodes[index].offset]);
+  }
+
+ private:
+  const bvh_build_options&       options;
+  const LeafOf&                  leaf_of;
+  const std::vector<motion_box>& object_motion;
+  size_t                         leaf_span;
+
+  void build_children(std::vector<bvh_build_primitive>& prims, uint32_t index, size_t start, size_t mid,
+                      size_t end, int depth, flat_bvh<Leaf>& tree, int threads) const {
+    // Appends the subtrees of the spans [start, mid) and [mid, end) after the node of the
+    // given index, the last one in the tree, and links the second to it.
+    if (threads == 1 || end - start < parallel_span) {
+      build(prims, start, mid, depth + 1, tree, 1);
+      tree.nodes[index].offset = static_cast<uint32_t>(tree.nodes.size());
+      build(prims, mid, end, depth + 1, tree, 1);
+      return;
+    }
+
+    // The second child is built on another thread into a tree of its own, which is then
+    // appended with its indices shifted: the same layout as building it here.
+    flat_bvh<Leaf> second;
+    std::thread worker([&] { build(prims, mid, end, depth + 1, second, threads / 2); });
+    build(prims, start, mid, depth + 1, tree, threads - threads / 2);
+    worker.join();
+
+    auto node_base = static_cast<uint32_t>(tree.nodes.size());
+    auto primitive_base = static_cast<uint32_t>(tree.primitives.size());
+    tree.nodes[index].offset = node_base;
+    for (auto node : second.nodes) {
+      node.offset += node.count > 0 ? primitive_base : node_base;
+      tree.nodes.push_back(node);
+    }
+    tree.motion.insert(tree.motion.end(), second.motion.begin(), second.motion.end());
+    tree.primitives.insert(tree.primitives.end(), second.primitives.begin(), second.primitives.end());
+  }
+};
+
+template <typename Leaf, typename LeafOf>
+flat_bvh<Leaf> build_flat_bvh(std::vector<bvh_build_primitive>& prims, const bvh_build_options& options,
+                              int threads, const LeafOf& leaf_of,
+                              const std::vector<motion_box>& object_motion = {}, size_t leaf_span = 1) {
+  // Builds the tree over the records of the primitives (see flat_bvh_builder), which it
+  // leaves in the order of the leaves.
+  flat_bvh<Leaf> tree;
+  if (prims.empty())
+    return tree;
+  if (options.split == bvh_split::lbvh)
+    sort_by_morton_code(prims, threads);
+
+  tree.primitives.reserve(prims.size());
+  flat_bvh_builder<Leaf, LeafOf>(options, leaf_of, object_motion, leaf_span)
+      .build(prims, 0, prims.size(), 0, tree, threads);
+  return tree;
+}
+
+template <typename HitBox, typename HitLeaf>
+bool hit_flat_bvh(const linear_bvh_node* nodes, uint32_t root, interval& ray_t, const HitBox& hit_box,
+                  const HitLeaf& hit_leaf) {
+  // Closest hit in the subtree of the given node, front to back. hit_box(index, ray_t, entry)
+  // tests the box of a node against the ray, and hit_leaf(node, ray_t) the primitives of a
+  // leaf, lowering ray_t.max to the closest hit; both hold the ray themselves. Both children of a node are tested there: the traversal
+  // goes on into the nearer one they are hit, and the farther one is pushed with its entry
+  // distance, to be skipped when popped if a hit closer than that has been found since.
+  real entry;
+  RTW_COUNT(box_tests);
+  if (!hit_box(root, ray_t, entry))
+    return false;
+
+  struct pending { uint32_t index; real entry; };
+  pending stack[bvh_max_depth];
+  int top = 0;
+  uint32_t index = root;
+  bool hit_anything = false;
+
+  while (true) {
+    const auto& node = nodes[index];
+
+    if (node.count > 0) {
+      if (hit_leaf(node, ray_t))
+        hit_anything = true;
+    } else {
+      uint32_t first = index + 1, second = node.offset;
+      real first_entry, second_entry;
+      RTW_ADD(box_tests, 2);  // Both children
+      bool hit_first = hit_box(first, ray_t, first_entry);
+      bool hit_second = hit_box(second, ray_t, second_entry);
+
+      if (hit_first && hit_second) {
+        if (second_entry < first_entry) {
+          std::swap(first, second);
+          std::swap(first_entry, second_entry);
+        }
+        stack[top++] = {second, second_entry};
+        index = first;
+        continue;
+      }
+      if (hit_first || hit_second) {
+        index = hit_first ? first : second;
+        continue;
+      }
+    }
+
+    // Next pending node that may still hold a closer hit.
+    while (top > 0 && stack[top - 1].entry >= ray_t.max)
+      --top;
+    if (top == 0)
+      break;
+    index = stack[--top].index;
+  }
+
+  return hit_anything;
+}
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_FLAT_BVH_H_
@@ -0,0 +1,157 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: framebuffer.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: The framebuffer class holds the rendered image in memory, so the render
+ * threads can write pixels in any order and the image is emitted once it is finished.
+ * The image is written in one bulk operation as ASCII PPM (P3), binary PPM (P6) or
+ * 32-bit float PFM, which keeps the linear (HDR) colors for post-processing.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_FRAMEBUFFER_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_FRAMEBUFFER_H_
+
+#include "rtweekend.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+enum class image_format {
+  ppm_ascii,   // P3: gamma-corrected 8-bit values as text
+  ppm_binary,  // P6: gamma-corrected 8-bit values as bytes
+  pfm,         // PF: linear 32-bit float values, bottom row first
+};
+
+inline image_format image_format_for(const std::string& path) {
+  // Chooses the format of an image file from its extension: .pfm for PFM, else binary PPM.
+  auto ends_with = [&](const char* ext) {
+    auto n = std::strlen(ext);
+    return path.size() >= n && path.compare(path.size() - n, n, ext) == 0;
+  };
+  return ends_with(".pfm") ? image_format::pfm : image_format::ppm_binary;
+}
+
+class framebuffer {
+  // The framebuffer class stores one linear color per pixel in row-major order.
+ public:
+  framebuffer() = default;
+
+  framebuffer(int width, int height)
+      : image_width(width), image_height(height),
+        pixels(static_cast<size_t>(width) * height) {}
+
+  [[nodiscard]] int width() const { return image_width; }
+  [[nodiscard]] int height() const { return image_height; }
+
+  // Every pixel is owned by exactly one tile, so concurrent writers never touch the same element.
+  color& at(int i, int j) { return pixels[static_cast<size_t>(j) * image_width + i]; }
+  [[nodiscard]] const color& at(int i, int j) const {
+    return pixels[static_cast<size_t>(j) * image_width + i];
+  }
+
+  void write(std::ostream& out, image_format format) const {
+    // Writes the whole image in the given format.
+    switch (format) {
+      case image_format::ppm_ascii:  write_ppm(out); break;
+      case image_format::ppm_binary: write_ppm_binary(out); break;
+      case image_format::pfm:        write_pfm(out); break;
+    }
+  }
+
+  void write_ppm(std::ostream& out) const {
+    // Writes the whole image as an ASCII PPM (P3) file, with the same text write_color
+    // produces, formatted into one buffer from a table of the 256 possible values.
+    static const auto decimals = [] {
+      std::vector<std::string> table(256);
+      for (int value = 0; value < 256; ++value)
+        table[value] = std::to_string(value);
+      return table;
+    }();
+
+    auto bytes = quantize();
+    std::string text;
+    text.reserve(bytes.size() * 4);
+    for (size_t k = 0; k < bytes.size(); k += 3) {
+      text += decimals[bytes[k]];
+      text += ' ';
+      text += decimals[bytes[k + 1]];
+      text += ' ';
+      text += decimals[bytes[k + 2]];
+      text += '\n';
+    }
+
+    out << "P3\n" << image_width << ' ' << image_height << "\n255\n";
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+  }
+
+  void write_ppm_binary(std::ostream& out) const {
+    // Writes the whole image as a binary PPM (P6) file.
+    auto bytes = quantize();
+    out << "P6\n" << image_width << ' ' << image_height << "\n255\n";
+    out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+  }
+
+  void write_pfm(std::ostream& out) const {
+    // Writes the linear colors as a little-endian PFM file (negative scale), whose rows
+    // run from the bottom of the image to the top.
+    std::vector<float> values(pixels.size() * 3);
+    auto row_size = static_cast<size_t>(image_width) * 3;
+    const real* linear = components();
+
+    for (int j = 0; j < image_height; ++j) {
+      const real* row = linear + static_cast<size_t>(image_height - 1 - j) * row_size;
+      float* dest = values.data() + static_cast<size_t>(j) * row_size;
+      for (size_t k = 0; k < row_size; ++k)
+        dest[k] = static_cast<float>(row[k]);
+    }
+
+    out << "PF\n" << image_width << ' ' << image_height << "\n-1.0\n";
+    if (!little_endian())
+      for (auto& value : values)
+        value = byte_swapped(value);
+    out.write(reinterpret_cast<const char*>(values.data()),
+              static_cast<std::streamsize>(values.size() * sizeof(float)));
+  }
+
+  [[nodiscard]] std::vector<unsigned char> quantize() const {
+    // Returns the gamma-corrected 8-bit RGB values of all pixels, in row-major order.
+    std::vector<unsigned char> bytes(pixels.size() * 3);
+    quantize_components(components(), bytes.size(), bytes.data());
+    return bytes;
+  }
+
+ private:
+  int                image_width  = 0;   // Image width in pixels
+  int                image_height = 0;   // Image height in pixels
+  std::vector<color> pixels;             // Row-major pixel colors
+
+  static_assert(sizeof(color) == 3 * sizeof(real), "colors must be packed scalar triples");
+
+  [[nodiscard]] const real* components() const {
+    // The pixels as one array of RGB components.
+    return pixels.empty() ? nullptr : pixels.front().e;
+  }
+
+  static bool little_endian() {
+    const uint32_t one = 1;
+    unsigned char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+  }
+
+  static float byte_swapped(float value) {
+    unsigned char bytes[sizeof(float)];
+    std::memcpy(bytes, &value, sizeof(float));
+    std::reverse(bytes, bytes + sizeof(float));
+    std::memcpy(&value, bytes, sizeof(float));
+    return value;
+  }
+};
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_FRAMEBUFFER_H_
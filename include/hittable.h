@@ -17,6 +17,8 @@
 #include "rtweekend.h"
 
 #include "AABB.h"
+#include "ray_packet.h"
+#include "transform.h"
 
 class material;
 
@@ -28,10 +30,10 @@ class hit_record {
 public:
     point3  p; // The point of intersection.
     vec3    normal; // The normal at the point of intersection.
-    shared_ptr<material> mat; // The material of the object.
-    double  t; // The distance from the ray origin to the point of intersection.
-    double  u; // The u texture coordinate.
-    double  v; // The v texture coordinate;
+    int     mat_id = -1; // The index of the object's material in the material table.
+    real    t; // The distance from the ray origin to the point of intersection.
+    real    u; // The u texture coordinate.
+    real    v; // The v texture coordinate;
     bool    front_face;
 
     void set_face_normal(const ray& r, const vec3& outward_normal) {
@@ -52,10 +54,27 @@ public:
 
     virtual bool hit(const ray& r, interval ray_t, hit_record& rec) const = 0;
 
+    // Intersects the lanes of a packet selected by the mask, shortening the interval of every
+    // lane that hits. Returns the lanes that hit. By default every lane is traced on its own.
+    virtual lane_mask hit_packet(ray_packet& packet, lane_mask mask, hit_record* recs) const {
+        lane_mask hits = 0;
+        for (int lane = 0; lane < packet_width; ++lane)
+            if ((mask & (1u << lane)) && hit_lane(packet, lane, recs[lane]))
+                hits |= 1u << lane;
+        return hits;
+    }
+
     [[nodiscard]] virtual AABB bounding_box() const = 0;
 
+    // The bounds at the start and end of the shutter, for a BVH that interpolates them at the
+    // time of a ray. Objects that do not move (or whose motion is not linear) return their
+    // bounding box for both.
+    [[nodiscard]] virtual motion_box motion_bounding_box() const {
+        return {bounding_box(), bounding_box()};
+    }
+
     // The pdf_value function returns the probability density function value.
-    [[nodiscard]] virtual double pdf_value(const point3& o, const vec3& v) const {
+    [[nodiscard]] virtual real pdf_value(const point3& o, const vec3& v) const {
         return 0.0;
     }
 
@@ -63,6 +82,19 @@ public:
     [[nodiscard]] virtual vec3 random(const vec3& o) const {
         return {1, 0, 0};
     }
+
+protected:
+    bool hit_lane(ray_packet& packet, int lane, hit_record& rec) const {
+        // Traces one lane of a packet as a single ray, drawing from the lane's random stream.
+        auto& rng = thread_rng();
+        std::swap(rng, packet.rngs[lane]);
+        bool hit_anything = hit(packet.rays[lane], interval(packet.t_min, packet.t_max[lane]), rec);
+        std::swap(rng, packet.rngs[lane]);
+
+        if (hit_anything)
+            packet.t_max[lane] = rec.t;
+        return hit_anything;
+    }
 };
 
 class translate : public hittable {
@@ -91,6 +123,15 @@ class translate : public hittable {
     return bbox;
   }
 
+  [[nodiscard]] motion_box motion_bounding_box() const override {
+    auto motion = object->motion_bounding_box();
+    return {motion.start + offset, motion.end + offset};
+  }
+
+  // The wrapped object and the transform from its space to ours, for collapsing chains.
+  [[nodiscard]] const shared_ptr<hittable>& inner() const { return object; }
+  [[nodiscard]] affine_transform transform() const { return affine_transform::translation(offset); }
+
  private:
   shared_ptr<hittable> object;
   vec3 offset;
@@ -100,7 +141,7 @@ class translate : public hittable {
 class rotate_y : public hittable {
   // The class for y-axis rotation.
 public:
-  rotate_y(const shared_ptr<hittable>&object, double angle) : object(object) {
+  rotate_y(const shared_ptr<hittable>&object, real angle) : object(object) {
     auto radians = degrees_to_radians(angle);
     sin_theta = std::sin(radians);
     cos_theta = std::cos(radians);
@@ -174,10 +215,16 @@ public:
     return bbox;
   }
 
+  // The wrapped object and the transform from its space to ours, for collapsing chains.
+  [[nodiscard]] const shared_ptr<hittable>& inner() const { return object; }
+  [[nodiscard]] affine_transform transform() const {
+    return affine_transform::rotation(vec3(0, 1, 0), sin_theta, cos_theta);
+  }
+
  private:
     shared_ptr<hittable> object;
-    double sin_theta;
-    double cos_theta;
+    real sin_theta;
+    real cos_theta;
     AABB bbox;
 };
 #endif //RAYTRACINGINONEWEEKEND_HITTABLE_H
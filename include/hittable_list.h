@@ -19,6 +19,7 @@
 #include "AABB.h"
 #include "hittable.h"
 
+#include <vector>
 
 
 // The hittable_list class stores a list of hittable objects.
@@ -52,16 +53,32 @@ public:
         return hit_anything;
     }
 
+    lane_mask hit_packet(ray_packet& packet, lane_mask mask, hit_record* recs) const override {
+        // Every object shortens the intervals of the lanes it hits, like closest_so_far above.
+        lane_mask hits = 0;
+        for (const auto& object : objects)
+            hits |= object->hit_packet(packet, mask, recs);
+        return hits;
+    }
+
     [[nodiscard]] AABB bounding_box() const override {
         return bbox;
     }
 
+    [[nodiscard]] motion_box motion_bounding_box() const override {
+        // The union of the objects' boxes at either end bounds their union in between.
+        motion_box motion(AABB::empty, AABB::empty);
+        for (const auto& object : objects)
+            motion = motion_box(motion, object->motion_bounding_box());
+        return motion;
+    }
+
     // Calculates the probability density function (PDF) value for a ray from origin
     // in given direction by averaging the PDF values of all objects in the list.
     // origin: The starting point of the ray
     // direction: The direction vector of the ray
     // Returns: The weighted average of PDF values from all objects
-    [[nodiscard]] double pdf_value(const point3& origin, const vec3& direction) const override {
+    [[nodiscard]] real pdf_value(const point3& origin, const vec3& direction) const override {
       auto weight = 1.0 / objects.size();  // Weight for each object's contribution
       auto sum = 0.0;  // Accumulator for weighted PDF values
 
@@ -0,0 +1,100 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: instance.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: The instance class places a shared object (typically the bottom-level BVH of
+ * a model) in the world with an affine transform. Many instances can share one object, so
+ * every copy of a model costs one instance record instead of a copy of its geometry. A BVH
+ * over instances is the top level of a two-level acceleration structure; bvh_node collapses
+ * chains of translate and rotate_y wrappers into instances when it is built.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_INSTANCE_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_INSTANCE_H_
+
+#include "rtweekend.h"
+
+#include "AABB.h"
+#include "hittable.h"
+#include "transform.h"
+
+class instance : public hittable {
+ public:
+  instance(const shared_ptr<hittable>& object, const affine_transform& to_world)
+      : object(object), to_world(to_world), to_object(to_world.inverse())
+  {
+    bbox = to_world.bounds(object->bounding_box());
+  }
+
+  bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
+    // Transform the ray into object space. The direction is not renormalized, so a distance
+    // t along the object-space ray is the same distance along the world-space ray and the
+    // interval and rec.t carry over unchanged.
+    ray object_r(to_object.point(r.origin()), to_object.vector(r.direction()), r.time());
+
+    if (!object->hit(object_r, ray_t, rec))
+      return false;
+
+    // Transform the intersection point and normal back to world space. front_face needs no
+    // update: the dot product of direction and normal is the same in both spaces.
+    rec.p = to_world.point(rec.p);
+    rec.normal = unit_vector(to_object.transposed_vector(rec.normal));
+
+    return true;
+  }
+
+  [[nodiscard]] AABB bounding_box() const override {
+    return bbox;
+  }
+
+  [[nodiscard]] motion_box motion_bounding_box() const override {
+    // The corners of the object's box move linearly, and so do their transforms; the boxes
+    // of the transformed corners at both ends therefore bound them at any time in between.
+    auto motion = object->motion_bounding_box();
+    return {to_world.bounds(motion.start), to_world.bounds(motion.end)};
+  }
+
+  [[nodiscard]] const shared_ptr<hittable>& inner() const { return object; }
+  [[nodiscard]] const affine_transform& transform() const { return to_world; }
+
+ private:
+  shared_ptr<hittable> object;  // The shared object, in its own space
+  affine_transform to_world;    // Object space to world space
+  affine_transform to_object;   // World space to object space
+  AABB bbox;                    // World-space bounds
+};
+
+inline shared_ptr<hittable> collapse_transforms(const shared_ptr<hittable>& object) {
+  // Returns the object with a chain of translate, rotate_y and instance wrappers around it
+  // replaced by a single instance, so that a ray is transformed once instead of once per
+  // wrapper. Objects with fewer than two wrappers are returned as they are.
+  affine_transform to_world;
+  shared_ptr<hittable> inner = object;
+  int wrappers = 0;
+
+  for (;; ++wrappers) {
+    if (auto t = std::dynamic_pointer_cast<translate>(inner)) {
+      to_world = to_world * t->transform();
+      inner = t->inner();
+    } else if (auto r = std::dynamic_pointer_cast<rotate_y>(inner)) {
+      to_world = to_world * r->transform();
+      inner = r->inner();
+    } else if (auto i = std::dynamic_pointer_cast<instance>(inner)) {
+      to_world = to_world * i->transform();
+      inner = i->inner();
+    } else {
+      break;
+    }
+  }
+
+  if (wrappers < 2)
+    return object;
+  return make_shared<instance>(inner, to_world);
+}
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_INSTANCE_H_
@@ -14,56 +14,66 @@
 #ifndef RAYTRACINGINONEWEEKEND_INTERVAL_H
 #define RAYTRACINGINONEWEEKEND_INTERVAL_H
 
-class interval {
+template <typename T>
+class basic_interval {
 public:
-    double min, max;
+    using scalar_type = T;
 
-    interval() : min(+infinity), max(-infinity) {} // Default interval  is empty.
+    T min, max;
 
-    interval(double min, double max) : min(min), max(max) {}
+    basic_interval() : min(+infinity), max(-infinity) {} // Default interval  is empty.
 
-    interval(const interval&a, const interval&b) {
+    basic_interval(T min, T max) : min(min), max(max) {}
+
+    basic_interval(const basic_interval&a, const basic_interval&b) {
         // Create the interval tightly enclosing the two input intervals.
         min = a.min <= b.min ? a.min : b.min;
         max = a.max >= b.max ? a.max : b.max;
     }
 
-    double size() const {
+    T size() const {
         return max - min;
     }
 
-    bool contains(double x) const {
+    bool contains(T x) const {
         return min <= x && x <= max;
     }
 
-    bool surrounds(double x) const {
+    bool surrounds(T x) const {
         return min < x && x < max;
     }
 
-    double clamp(double x) const {
+    T clamp(T x) const {
         if (x < min) return min;
         if (x > max) return max;
         return x;
     }
 
-    interval expand(double delta) const {
+    basic_interval expand(T delta) const {
         // Expand the interval by a given delta to both sides.
-        auto half_delta = 0.5 * delta;
+        auto half_delta = T(0.5) * delta;
         return {min - half_delta, max + half_delta};
     }
 
-    static const interval empty, universe;
+    static const basic_interval empty, universe;
 };
 
-const interval interval::empty = interval(+infinity, -infinity);
-const interval interval::universe = interval(-infinity, +infinity);
+template <typename T>
+const basic_interval<T> basic_interval<T>::empty = basic_interval<T>(+infinity, -infinity);
+template <typename T>
+const basic_interval<T> basic_interval<T>::universe = basic_interval<T>(-infinity, +infinity);
 
-interval operator+(const interval& i, double x) {
+template <typename T>
+basic_interval<T> operator+(const basic_interval<T>& i, typename basic_interval<T>::scalar_type x) {
     // Return the interval expanded by the given value.
     return {i.min + x, i.max + x};
 }
 
-interval operator+(double x, const interval& i) {
+template <typename T>
+basic_interval<T> operator+(typename basic_interval<T>::scalar_type x, const basic_interval<T>& i) {
     return i + x;
 }
+
+using interval = basic_interval<real>;
+
 #endif //RAYTRACINGINONEWEEKEND_INTERVAL_H
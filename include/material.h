@@ -20,211 +20,430 @@
 #include "pdf.h"
 #include "texture.h"
 
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
 
 class scatter_record {
     // The scatter_record class stores the scattered ray, the attenuation,
     // and the probability density function value.
  public:
   color           attenuation;  // The attenuation of the scattered ray.
-  shared_ptr<pdf> pdf_ptr;      // The probability density function.
+  scatter_pdf     surface_pdf;  // The probability density function.
   bool            skip_pdf;     // Skip the probability density function.
   ray             skip_pdf_ray; // The ray to skip the probability density function.
 };
 
-class material {
-    // The material class is an abstract base class for materials.
-    // It provides a scatter function that returns a scattered ray
-    // or indicates that the ray was absorbed.
-public:
-    virtual ~material() = default;
+enum class material_type {
+    // The kinds of material. The wavefront integrator shades hits grouped by kind.
+    other,
+    lambertian,
+    metal,
+    dielectric,
+    diffuse_light,
+    isotropic,
+};
 
-    [[nodiscard]] virtual color emitted(
-        const ray& r_in, const hit_record& rec, double u, double v, const point3& p) const {
-        return {0, 0, 0};
+constexpr int material_type_count = 6;
+
+class material;
+
+struct material_record {
+    // One entry of the material table: plain data, evaluated by a switch on the type.
+    material_type   type = material_type::other;
+    color           albedo;                 // Reflectance (or emission) when there is no texture
+    real            fuzz = 0;               // Metal: fuzziness of the reflection
+    real            refraction_index = 1;   // Dielectric: refractive index
+    const material* source = nullptr;       // The material object, evaluated for type other
+    int             tex_id = -1;            // Index of the texture in the table, or -1
+
+    static material_record lambertian(const color& albedo = color()) {
+        material_record record;
+        record.type = material_type::lambertian;
+        record.albedo = albedo;
+        return record;
     }
 
-    virtual bool scatter (
-            const ray& r_in, const hit_record& rec, scatter_record& srec
-            ) const {
-        return false;
+    static material_record metal(const color& albedo, real fuzz) {
+        material_record record;
+        record.type = material_type::metal;
+        record.albedo = albedo;
+        record.fuzz = fuzz < 1 ? fuzz : 1;
+        return record;
     }
 
-    // The scattering_pdf function returns the probability density function
-    [[nodiscard]] virtual double scattering_pdf(
-            const ray& r_in, const hit_record& rec, const ray& scattered
-            ) const {
-        return 0;
+    static material_record dielectric(real refraction_index) {
+        material_record record;
+        record.type = material_type::dielectric;
+        record.albedo = color(1, 1, 1);
+        record.refraction_index = refraction_index;
+        return record;
+    }
+
+    static material_record diffuse_light(const color& emit = color()) {
+        material_record record;
+        record.type = material_type::diffuse_light;
+        record.albedo = emit;
+        return record;
+    }
+
+    static material_record isotropic(const color& albedo = color()) {
+        material_record record;
+        record.type = material_type::isotropic;
+        record.albedo = albedo;
+        return record;
     }
 };
 
-class lambertian : public material {
-    // The lambertian class represents a diffuse, or matte, material.
+static_assert(std::is_trivially_copyable_v<material_record>, "material records are copied as plain data");
+
+class material_table {
+    // The material_table class stores the live materials as material_records in contiguous
+    // blocks and evaluates them with a switch on the type, instead of virtual calls on objects
+    // spread over the heap. Textures other than solid colors are kept in blocks of their own,
+    // which the records refer to by index. The material classes below are its front end:
+    // constructing one compiles it into the global table, hit records carry its index, and
+    // destroying it frees the record and its texture for the next material, so rebuilding
+    // scenes does not grow the table. A scene owns its materials through the shared_ptrs of
+    // its objects, and so the lifetime of their records. Records are added and removed under
+    // a lock. The blocks never move, so threads that render with existing materials may read
+    // them while others create new ones.
 public:
-    explicit lambertian(const color& albedo) : tex(make_shared<solid_color>(albedo)) {}
-    explicit lambertian(shared_ptr<texture> a) : tex(std::move(a)) {}
-
-    bool scatter(
-            const ray& r_in, const hit_record& rec, scatter_record& srec
-            ) const override {
-      // Set the attenuation color for the scattered ray
-      srec.attenuation = tex->value(rec.u, rec.v, rec.p);
+    static material_table& global() {
+        static material_table table;
+        return table;
+    }
 
-      // Set the probability density function for the scattered ray
-      srec.pdf_ptr = make_shared<cosine_pdf>(rec.normal);
+    int add(material_record record, shared_ptr<texture> tex = nullptr) {
+        // Adds a record, and the texture it refers to, if any.
+        std::lock_guard<std::mutex> guard(lock);
+        record.tex_id = tex ? textures.add(std::move(tex)) : -1;
+        return records.add(record);
+    }
 
-      // Indicate that the PDF should not be skipped
-      srec.skip_pdf = false;
+    void set(int id, material_record record, shared_ptr<texture> tex = nullptr) {
+        // Replaces a record, and the texture it refers to.
+        std::lock_guard<std::mutex> guard(lock);
+        if (records[id].tex_id >= 0)
+            textures.remove(records[id].tex_id);
+        record.tex_id = tex ? textures.add(std::move(tex)) : -1;
+        records[id] = record;
+    }
 
-      // Indicate that the scattering was successful
-      return true;
+    void remove(int id) {
+        // Frees the record of a destroyed material, and the texture slot it refers to.
+        std::lock_guard<std::mutex> guard(lock);
+        if (records[id].tex_id >= 0)
+            textures.remove(records[id].tex_id);
+        records.remove(id);
     }
 
-    // The scattering_pdf function returns the probability density function
-    [[nodiscard]] double scattering_pdf(
-            const ray& r_in, const hit_record& rec, const ray& scattered
-            ) const override {
-        // Calculate the cosine of the angle between the surface normal
-        // and the scattered ray direction
-        auto cos_theta = dot(rec.normal, unit_vector(scattered.direction()));
+    [[nodiscard]] const material_record& record(int id) const { return records[id]; }
 
-        // Return the PDF value for the scattered direction
-        // If the cosine is negative, return 0 (indicating no scattering in that direction)
-        // Otherwise, return the cosine divided by pi (for cosine-weighted hemisphere sampling)
-        return cos_theta < 0 ? 0 : cos_theta / pi;
+    [[nodiscard]] shared_ptr<texture> texture_of(int id) const {
+        // The texture of a record, or null.
+        int tex_id = records[id].tex_id;
+        return tex_id >= 0 ? textures[tex_id] : nullptr;
     }
 
+    [[nodiscard]] material_type type(int id) const { return records[id].type; }
+
+    [[nodiscard]] color emitted(
+        int id, const ray& r_in, const hit_record& rec, real u, real v, const point3& p) const;
+
+    bool scatter(int id, const ray& r_in, const hit_record& rec, scatter_record& srec) const;
+
+    [[nodiscard]] real scattering_pdf(
+        int id, const ray& r_in, const hit_record& rec, const ray& scattered) const;
+
 private:
-//    color albedo; // The albedo of the material.
-    shared_ptr<texture> tex;
+    template <typename T>
+    class slots {
+        // Slots in fixed blocks that never move; freed slots are reused first.
+    public:
+        int add(T value) {
+            int id;
+            if (!free_ids.empty()) {
+                id = free_ids.back();
+                free_ids.pop_back();
+            } else {
+                if (size == max_blocks * block_size)
+                    throw std::length_error("material_table: too many live materials");
+                id = size++;
+                if (!blocks[id / block_size])
+                    blocks[id / block_size] = std::make_unique<T[]>(block_size);
+            }
+            (*this)[id] = std::move(value);
+            return id;
+        }
+
+        void remove(int id) {
+            (*this)[id] = T();
+            free_ids.push_back(id);
+        }
+
+        T& operator[](int id) const { return blocks[id / block_size][id % block_size]; }
+
+    private:
+        static constexpr int block_size = 1024;  // Slots per block
+        static constexpr int max_blocks = 1024;  // Blocks, i.e. at most 2^20 slots
+
+        std::unique_ptr<T[]> blocks[max_blocks];
+        int                  size = 0;  // Slots ever used, including the freed ones
+        std::vector<int>     free_ids;  // Freed slots, reused first
+    };
+
+    slots<material_record>     records;
+    slots<shared_ptr<texture>> textures;
+    std::mutex                 lock;  // Guards adding, setting and removing records
+
+    [[nodiscard]] color albedo(const material_record& m, real u, real v, const point3& p) const {
+        return m.tex_id >= 0 ? textures[m.tex_id]->value(u, v, p) : m.albedo;
+    }
+
+    static real reflectance(real cosine, real refraction_index) {
+        // Schlick's approximation for reflectance.
+        auto r0 = (1 - refraction_index) / (1 + refraction_index);
+        r0 = r0 * r0;
+        return r0 + (1 - r0) * std::pow((1 - cosine), 5);
+    }
 };
 
-class metal : public material {
-    // The metal class represents a reflective material.
+class material {
+    // The material class is the base class for materials. The built-in materials are
+    // evaluated from the material table; other materials derive from material and override
+    // emitted, scatter and scattering_pdf.
 public:
-    metal(const color& albedo, double fuzz) : albedo(albedo), fuzz(fuzz < 1 ? fuzz : 1) {}
+    virtual ~material() {
+        material_table::global().remove(material_id);
+    }
 
-    bool scatter(
-            const ray& r_in, const hit_record& rec, scatter_record& srec
-            ) const override {
-        // Reflect the ray around the normal.
-        vec3 reflected = reflect(r_in.direction(), rec.normal);
+    material(const material& other) {
+        // A copy has a record of its own, with the same parameters.
+        auto& table = material_table::global();
+        material_record record = table.record(other.material_id);
+        record.source = this;
+        material_id = table.add(record, table.texture_of(other.material_id));
+    }
 
-        // Add fuzziness to the reflection by adding a random unit vector scaled by the fuzz factor.
-        reflected = unit_vector(reflected) + fuzz * random_unit_vector();
+    material& operator=(const material& other) {
+        if (this != &other) {
+            auto& table = material_table::global();
+            material_record record = table.record(other.material_id);
+            record.source = this;
+            table.set(material_id, record, table.texture_of(other.material_id));
+        }
+        return *this;
+    }
 
-        // Set the attenuation color for the scattered ray.
-        srec.attenuation = albedo;
+    // The index of the material in the material table.
+    [[nodiscard]] int id() const { return material_id; }
 
-        // No probability density function is used for this material.
-        srec.pdf_ptr = nullptr;
+    [[nodiscard]] material_type type() const {
+        return material_table::global().type(material_id);
+    }
 
-        // Indicate that the PDF should be skipped.
-        srec.skip_pdf = true;
+    [[nodiscard]] virtual color emitted(
+        const ray& r_in, const hit_record& rec, real u, real v, const point3& p) const {
+        if (type() == material_type::other)
+            return {0, 0, 0};
+        return material_table::global().emitted(material_id, r_in, rec, u, v, p);
+    }
 
-        // Set the scattered ray to the reflected ray.
-        srec.skip_pdf_ray = ray(rec.p, reflected, r_in.time());
+    virtual bool scatter (
+            const ray& r_in, const hit_record& rec, scatter_record& srec
+            ) const {
+        return type() != material_type::other
+            && material_table::global().scatter(material_id, r_in, rec, srec);
+    }
+
+    // The scattering_pdf function returns the probability density function
+    [[nodiscard]] virtual real scattering_pdf(
+            const ray& r_in, const hit_record& rec, const ray& scattered
+            ) const {
+        if (type() == material_type::other)
+            return 0;
+        return material_table::global().scattering_pdf(material_id, r_in, rec, scattered);
+    }
+
+protected:
+    material() {
+        material_record record;
+        record.source = this;
+        material_id = material_table::global().add(record);
+    }
 
-        // Indicate that the scattering was successful.
-        return true;
+    void compile(material_record record, shared_ptr<texture> tex = nullptr) {
+        // Store the material's parameters in its table record. A solid color texture is
+        // stored as a plain albedo; any other texture is added to the table's textures, and
+        // the record keeps its index.
+        if (tex && dynamic_cast<const solid_color*>(tex.get())) {
+            record.albedo = tex->value(0, 0, point3());
+            tex = nullptr;
+        }
+        record.source = this;
+        material_table::global().set(material_id, record, std::move(tex));
     }
 
 private:
-    color   albedo; // The albedo of the material.
-    double  fuzz;   // The fuzziness of the reflection.
+    int material_id;
 };
 
-class  dielectric : public material {
-    // The dielectric class represents a transparent material.
+class lambertian : public material {
+    // The lambertian class represents a diffuse, or matte, material.
 public:
-    explicit dielectric(double refraction_index) : refraction_index(refraction_index) {}
-
-    bool scatter(
-            const ray& r_in, const hit_record& rec, scatter_record& srec
-            ) const override {
-        srec.attenuation  = color(1.0, 1.0, 1.0);
-        srec.pdf_ptr      = nullptr;
-        srec.skip_pdf     = true;
-        // To judge the ray is inside or outside the object.
-        double ri = rec.front_face ? (1.0 / refraction_index) : refraction_index;
-
-        vec3    unit_direction = unit_vector(r_in.direction());
-        double  cos_theta = std::fmin(dot(-unit_direction, rec.normal), 1.0);
-        double  sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
-
-        bool    cannot_refract = ri * sin_theta > 1.0;
-        vec3    direction;
+    explicit lambertian(const color& albedo) {
+        compile(material_record::lambertian(albedo));
+    }
 
-        // Determining if the ray can refract.
-        if (cannot_refract || reflectance(cos_theta, ri) > random_double())
-            direction = reflect(unit_direction, rec.normal);
-        else
-            direction = refract(unit_direction, rec.normal, ri);
+    explicit lambertian(shared_ptr<texture> a) {
+        compile(material_record::lambertian(), std::move(a));
+    }
+};
 
-        srec.skip_pdf_ray = ray(rec.p, direction,r_in.time());
-        return true;
+class metal : public material {
+    // The metal class represents a reflective material.
+public:
+    metal(const color& albedo, real fuzz) {
+        compile(material_record::metal(albedo, fuzz));
     }
+};
 
-private:
+class  dielectric : public material {
+    // The dielectric class represents a transparent material.
+public:
     // Refractive index in vacuum or air, or the ratio of the material's refractive index over
     // the refractive index of the enclosing media
-    double refraction_index; // The refractive index of the material.
-
-    static double reflectance(double cosine, double refraction_index) {
-        // Schlick's approximation for reflectance.
-        auto r0 = (1 - refraction_index) / (1 + refraction_index);
-        r0 = r0 * r0;
-        return r0 + (1 - r0) * std::pow((1 - cosine), 5);
+    explicit dielectric(real refraction_index) {
+        compile(material_record::dielectric(refraction_index));
     }
 };
 
 class diffuse_light : public material {
     // The diffuse_light class represents a light-emitting material.
 public:
-  explicit diffuse_light(shared_ptr<texture> tex) : tex(std::move(tex)) {}
-  explicit diffuse_light(const color& emit) : tex(make_shared<solid_color>(emit)) {}
-
-  [[nodiscard]] color emitted(
-      const ray& r_in, const hit_record& rec, double u, double v, const point3& p) const override{
-
-    // If the ray is hitting the back face of the surface, return black color (no emission).
-    if (!rec.front_face)
-      return {0, 0, 0};
-    return tex->value(u, v, p);
+  explicit diffuse_light(shared_ptr<texture> tex) {
+    compile(material_record::diffuse_light(), std::move(tex));
   }
 
-private:
-    shared_ptr<texture> tex;
+  explicit diffuse_light(const color& emit) {
+    compile(material_record::diffuse_light(emit));
+  }
 };
 
 class isotropic : public material {
   // The isotropic class represents a material that scatters light in all directions.
  public:
-  explicit isotropic(const color& albedo) : tex(make_shared<solid_color>(albedo)) {}
-  explicit isotropic(shared_ptr<texture> tex) : tex(std::move(tex)) {}
-
-  bool scatter(
-      const ray& r_in, const hit_record& rec, scatter_record& srec
-      ) const override {
-    // Set the attenuation color for the scattered ray
-    srec.attenuation = tex->value(rec.u, rec.v, rec.p);
-
-    // Set the probability density function for the scattered ray
-    srec.pdf_ptr = make_shared<sphere_pdf>();
-
-    // Indicate that the PDF should not be skipped
-    srec.skip_pdf = false;
-
-    // Indicate that the scattering was successful
-    return true;
+  explicit isotropic(const color& albedo) {
+    compile(material_record::isotropic(albedo));
   }
 
-  [[nodiscard]] double scattering_pdf(
-      const ray& r_in, const hit_record& rec, const ray& scattered
-      ) const override {
-    return 1 / (4 * pi);
+  explicit isotropic(shared_ptr<texture> tex) {
+    compile(material_record::isotropic(), std::move(tex));
   }
-
- private:
-  shared_ptr<texture> tex;
 };
+
+inline color material_table::emitted(
+    int id, const ray& r_in, const hit_record& rec, real u, real v, const point3& p) const {
+    const auto& m = records[id];
+    switch (m.type) {
+        case material_type::diffuse_light:
+            // If the ray is hitting the back face of the surface, return black color (no emission).
+            if (!rec.front_face)
+                return {0, 0, 0};
+            return albedo(m, u, v, p);
+
+        case material_type::other:
+            return m.source->emitted(r_in, rec, u, v, p);
+
+        default:
+            return {0, 0, 0};
+    }
+}
+
+inline bool material_table::scatter(
+    int id, const ray& r_in, const hit_record& rec, scatter_record& srec) const {
+    const auto& m = records[id];
+    switch (m.type) {
+        case material_type::lambertian:
+            // Cosine-weighted diffuse reflection.
+            srec.attenuation = albedo(m, rec.u, rec.v, rec.p);
+            srec.surface_pdf = cosine_pdf(rec.normal);
+            srec.skip_pdf = false;
+            return true;
+
+        case material_type::metal: {
+            // Reflect the ray around the normal, with fuzziness added by a random unit vector.
+            vec3 reflected = reflect(r_in.direction(), rec.normal);
+            reflected = unit_vector(reflected) + m.fuzz * random_unit_vector();
+
+            srec.attenuation = m.albedo;
+            srec.skip_pdf = true;
+            srec.skip_pdf_ray = ray(rec.p, reflected, r_in.time());
+            return true;
+        }
+
+        case material_type::dielectric: {
+            srec.attenuation  = m.albedo;
+            srec.skip_pdf     = true;
+            // To judge the ray is inside or outside the object.
+            real ri = rec.front_face ? (1.0 / m.refraction_index) : m.refraction_index;
+
+            vec3    unit_direction = unit_vector(r_in.direction());
+            real    cos_theta = std::fmin(dot(-unit_direction, rec.normal), 1.0);
+            real    sin_theta = std::sqrt(1.0 - cos_theta * cos_theta);
+
+            bool    cannot_refract = ri * sin_theta > 1.0;
+            vec3    direction;
+
+            // Determining if the ray can refract.
+            if (cannot_refract || reflectance(cos_theta, ri) > random_double())
+                direction = reflect(unit_direction, rec.normal);
+            else
+                direction = refract(unit_direction, rec.normal, ri);
+
+            srec.skip_pdf_ray = ray(rec.p, direction, r_in.time());
+            return true;
+        }
+
+        case material_type::isotropic:
+            // Uniform scattering over the sphere of directions.
+            srec.attenuation = albedo(m, rec.u, rec.v, rec.p);
+            srec.surface_pdf = sphere_pdf();
+            srec.skip_pdf = false;
+            return true;
+
+        case material_type::other:
+            return m.source->scatter(r_in, rec, srec);
+
+        default:
+            return false;
+    }
+}
+
+inline real material_table::scattering_pdf(
+    int id, const ray& r_in, const hit_record& rec, const ray& scattered) const {
+    const auto& m = records[id];
+    switch (m.type) {
+        case material_type::lambertian: {
+            // Cosine of the angle between the normal and the scattered direction, over pi;
+            // zero below the surface.
+            auto cos_theta = dot(rec.normal, unit_vector(scattered.direction()));
+            return cos_theta < 0 ? 0 : cos_theta / pi;
+        }
+
+        case material_type::isotropic:
+            return 1 / (4 * pi);
+
+        case material_type::other:
+            return m.source->scattering_pdf(r_in, rec, scattered);
+
+        default:
+            return 0;
+    }
+}
+
 #endif //RAYTRACINGINONEWEEKEND_MATERIAL_H
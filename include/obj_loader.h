@@ -0,0 +1,269 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: obj_loader.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: A loader of Wavefront OBJ files into the arrays of a triangle_mesh. The file is
+ * streamed in large blocks, so files of several gigabytes never sit in memory at once. Every
+ * block is cut into one chunk of whole lines per thread, the chunks are parsed in parallel,
+ * and their vertices and faces are appended in file order. Only the geometry is read: "v",
+ * "vt", "vn" and "f" lines (polygons are split into triangle fans, negative indices count
+ * back from the last vertex); all other lines are skipped.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_OBJ_LOADER_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_OBJ_LOADER_H_
+
+#include "rtweekend.h"
+
+#include "triangle_mesh.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+class obj_loader {
+ public:
+  static constexpr size_t block_size = size_t(64) << 20;  // Bytes read from the file at once
+
+  static mesh_data load(const std::string& filename, int threads = 0) {
+    // Returns the mesh of the file, or an empty mesh if it cannot be read. Faces that refer
+    // to vertices that do not exist are skipped. Normals and texture coordinates are kept
+    // only if every face has them.
+    std::ifstream in(filename, std::ios::binary);
+    if (!in) {
+      std::cerr << "ERROR: Could not load OBJ file '" << filename << "'.\n";
+      return {};
+    }
+    if (threads <= 0)
+      threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    mesh_data mesh;
+    bool missing_normals = false, missing_uvs = false;
+    std::string buffer, carry;
+
+    while (true) {
+      // Read a block after the unfinished line of the previous one, and parse its whole lines.
+      buffer.swap(carry);
+      size_t kept = buffer.size();
+      buffer.resize(kept + block_size);
+      in.read(&buffer[kept], static_cast<std::streamsize>(block_size));
+      buffer.resize(kept + static_cast<size_t>(in.gcount()));
+      bool last = !in;
+
+      size_t cut = buffer.size();
+      if (!last) {
+        size_t newline = buffer.rfind('\n');
+        cut = newline == std::string::npos ? 0 : newline + 1;
+      }
+      carry.assign(buffer, cut, std::string::npos);
+      parse_block(buffer.data(), buffer.data() + cut, threads, mesh, missing_normals, missing_uvs);
+
+      if (last)
+        break;
+    }
+
+    if (missing_normals)
+      std::vector<uint32_t>().swap(mesh.normal_indices);
+    if (missing_uvs)
+      std::vector<uint32_t>().swap(mesh.uv_indices);
+    remove_invalid_faces(mesh, filename);
+    return mesh;
+  }
+
+ private:
+  // Face indices as parsed: absolute (zero-based) indices, indices relative to the number of
+  // vertices the chunk had read so far (offset by relative_base, and resolved when the counts
+  // of the chunks before it are known), or missing.
+  static constexpr int64_t relative_base = int64_t(1) << 48;
+  static constexpr int64_t missing = -1;
+
+  struct chunk {
+    std::vector<point3>  positions;
+    std::vector<vec3>    normals;
+    std::vector<mesh_uv> uvs;
+    std::vector<int64_t> position_refs, normal_refs, uv_refs;  // Three per triangle
+    bool                 missing_normals = false, missing_uvs = false;
+  };
+
+  static void parse_block(const char* begin, const char* end, int threads, mesh_data& mesh,
+                          bool& missing_normals, bool& missing_uvs) {
+    // Parses the lines in [begin, end) in one chunk per thread and appends them to the mesh.
+    size_t pieces = std::max<size_t>(1, std::min<size_t>(threads, (end - begin) / (size_t(1) << 20)));
+    std::vector<const char*> bounds = {begin};
+    for (size_t k = 1; k < pieces; ++k) {
+      const char* cut = begin + (end - begin) * k / pieces;
+      cut = std::max(cut, bounds.back());
+      auto newline = static_cast<const char*>(std::memchr(cut, '\n', end - cut));
+      bounds.push_back(newline ? newline + 1 : end);
+    }
+    bounds.push_back(end);
+
+    std::vector<chunk> chunks(pieces);
+    std::vector<std::thread> workers;
+    for (size_t k = 1; k < pieces; ++k)
+      workers.emplace_back([&, k] { parse_chunk(bounds[k], bounds[k + 1], chunks[k]); });
+    parse_chunk(bounds[0], bounds[1], chunks[0]);
+    for (auto& worker : workers)
+      worker.join();
+
+    for (const auto& c : chunks) {
+      append_refs(c.position_refs, mesh.positions.size(), mesh.position_indices);
+      append_refs(c.normal_refs, mesh.normals.size(), mesh.normal_indices);
+      append_refs(c.uv_refs, mesh.uvs.size(), mesh.uv_indices);
+      mesh.positions.insert(mesh.positions.end(), c.positions.begin(), c.positions.end());
+      mesh.normals.insert(mesh.normals.end(), c.normals.begin(), c.normals.end());
+      mesh.uvs.insert(mesh.uvs.end(), c.uvs.begin(), c.uvs.end());
+      missing_normals |= c.missing_normals;
+      missing_uvs |= c.missing_uvs;
+    }
+  }
+
+  static void append_refs(const std::vector<int64_t>& refs, size_t base, std::vector<uint32_t>& indices) {
+    // Resolves the face indices of a chunk, whose vertices follow the first base ones.
+    // Indices that cannot be valid become UINT32_MAX.
+    size_t first = indices.size();
+    indices.resize(first + refs.size());
+    for (size_t i = 0; i < refs.size(); ++i) {
+      int64_t index = refs[i] >= relative_base / 2 ? static_cast<int64_t>(base) + (refs[i] - relative_base) : refs[i];
+      indices[first + i] = index < 0 || index >= UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(index);
+    }
+  }
+
+  static void remove_invalid_faces(mesh_data& mesh, const std::string& filename) {
+    // Drops the triangles with an index past the end of its array.
+    size_t count = mesh.triangle_count(), kept = 0;
+    for (size_t i = 0; i < count; ++i) {
+      bool valid = true;
+      for (int k = 0; k < 3; ++k) {
+        valid &= mesh.position_indices[3 * i + k] < mesh.positions.size();
+        valid &= mesh.normal_indices.empty() || mesh.normal_indices[3 * i + k] < mesh.normals.size();
+        valid &= mesh.uv_indices.empty() || mesh.uv_indices[3 * i + k] < mesh.uvs.size();
+      }
+      if (!valid)
+        continue;
+      for (int k = 0; k < 3; ++k) {
+        mesh.position_indices[3 * kept + k] = mesh.position_indices[3 * i + k];
+        if (!mesh.normal_indices.empty())
+          mesh.normal_indices[3 * kept + k] = mesh.normal_indices[3 * i + k];
+        if (!mesh.uv_indices.empty())
+          mesh.uv_indices[3 * kept + k] = mesh.uv_indices[3 * i + k];
+      }
+      ++kept;
+    }
+
+    if (kept < count)
+      std::cerr << "WARNING: Skipped " << count - kept << " triangles with invalid indices in '" << filename << "'.\n";
+    mesh.position_indices.resize(3 * kept);
+    if (!mesh.normal_indices.empty())
+      mesh.normal_indices.resize(3 * kept);
+    if (!mesh.uv_indices.empty())
+      mesh.uv_indices.resize(3 * kept);
+  }
+
+  static void parse_chunk(const char* p, const char* end, chunk& out) {
+    // Parses the lines of a chunk.
+    std::vector<int64_t> corners[3];  // Position, texture coordinate and normal of every corner
+
+    while (p < end) {
+      auto newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+      const char* line_end = newline ? newline : end;
+      p = skip_space(p, line_end);
+
+      if (line_end - p >= 2 && p[0] == 'v' && is_space(p[1])) {
+        point3 v;
+        for (int k = 0; k < 3; ++k)
+          p = parse_real(p + (k == 0), line_end, v[k]);
+        out.positions.push_back(v);
+      } else if (line_end - p >= 3 && p[0] == 'v' && p[1] == 'n' && is_space(p[2])) {
+        vec3 n;
+        for (int k = 0; k < 3; ++k)
+          p = parse_real(p + 2 * (k == 0), line_end, n[k]);
+        out.normals.push_back(n);
+      } else if (line_end - p >= 3 && p[0] == 'v' && p[1] == 't' && is_space(p[2])) {
+        mesh_uv uv{0, 0};
+        p = parse_real(p + 2, line_end, uv.u);
+        p = parse_real(p, line_end, uv.v);
+        out.uvs.push_back(uv);
+      } else if (line_end - p >= 2 && p[0] == 'f' && is_space(p[1])) {
+        for (auto& c : corners)
+          c.clear();
+        p = skip_space(p + 1, line_end);
+        while (p < line_end) {
+          // A corner is "v", "v/vt", "v//vn" or "v/vt/vn".
+          int64_t refs[3] = {missing, missing, missing};
+          size_t counts[3] = {out.positions.size(), out.uvs.size(), out.normals.size()};
+          for (int k = 0; k < 3 && p < line_end && !is_space(*p); ++k) {
+            if (k > 0) {
+              if (*p != '/')
+                break;
+              ++p;
+            }
+            int64_t index = 0;
+            auto [next, error] = std::from_chars(p, line_end, index);
+            if (error == std::errc()) {
+              refs[k] = index > 0 ? index - 1
+                        : index < 0 ? relative_base + static_cast<int64_t>(counts[k]) + index
+                        : int64_t(UINT32_MAX);
+              p = next;
+            }
+          }
+          if (refs[0] == missing)
+            refs[0] = UINT32_MAX;  // An unreadable corner, whose triangles are dropped
+          for (int k = 0; k < 3; ++k)
+            corners[k].push_back(refs[k]);
+          while (p < line_end && !is_space(*p))
+            ++p;
+          p = skip_space(p, line_end);
+        }
+
+        // Split the polygon into a fan of triangles around its first corner.
+        for (size_t i = 2; i < corners[0].size(); ++i) {
+          for (size_t corner : {size_t(0), i - 1, i}) {
+            out.position_refs.push_back(corners[0][corner]);
+            out.uv_refs.push_back(corners[1][corner]);
+            out.normal_refs.push_back(corners[2][corner]);
+            out.missing_uvs |= corners[1][corner] == missing;
+            out.missing_normals |= corners[2][corner] == missing;
+          }
+        }
+      }
+
+      p = newline ? newline + 1 : end;
+    }
+  }
+
+  static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+  }
+
+  static const char* skip_space(const char* p, const char* end) {
+    while (p < end && is_space(*p))
+      ++p;
+    return p;
+  }
+
+  static const char* parse_real(const char* p, const char* end, real& value) {
+    // Parses the number after p (and any blanks); a missing number leaves value as it is.
+    p = skip_space(p, end);
+    if (p < end && *p == '+')
+      ++p;
+    auto [next, error] = std::from_chars(p, end, value);
+    return error == std::errc() ? next : p;
+  }
+};
+
+inline mesh_data load_obj(const std::string& filename, int threads = 0) {
+  // Reads the triangles of a Wavefront OBJ file (see obj_loader).
+  return obj_loader::load(filename, threads);
+}
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_OBJ_LOADER_H_
@@ -11,22 +11,24 @@
 #include "hittable_list.h"
 #include "onb.h"
 
+#include <variant>
+
 
 class pdf {
  public:
   virtual ~pdf() = default;
 
-  [[nodiscard]] virtual double value(const vec3& direction) const = 0;
+  [[nodiscard]] virtual real value(const vec3& direction) const = 0;
   [[nodiscard]] virtual vec3 generate() const = 0;
 };
 
-class sphere_pdf : public pdf {
+class sphere_pdf final : public pdf {
   // The sphere_pdf class represents a probability density function for a uniform density over the unit sphere.
  public:
   sphere_pdf() = default;
 
   // The value function returns the probability density function value for the given direction.
-  [[nodiscard]] double value(const vec3& direction) const override {
+  [[nodiscard]] real value(const vec3& direction) const override {
     return 1 / (4 * pi);
   }
 
@@ -37,13 +39,13 @@ class sphere_pdf : public pdf {
 };
 
 
-class cosine_pdf : public pdf {
+class cosine_pdf final : public pdf {
   // The cosine_pdf class represents a probability density function for a cosine-weighted hemisphere.
  public:
   explicit cosine_pdf(const vec3& w) : uvw(w) {}
 
   // The value function returns the probability density function value for the given direction.
-  [[nodiscard]] double value(const vec3& direction) const override {
+  [[nodiscard]] real value(const vec3& direction) const override {
     auto cosine_theta = dot(unit_vector(direction), uvw.w());
     return (cosine_theta <= 0) ? 0 : cosine_theta / pi;
   }
@@ -57,13 +59,33 @@ class cosine_pdf : public pdf {
   onb uvw;
 };
 
-class hittable_pdf : public pdf {
+class scatter_pdf : public pdf {
+  // The scatter_pdf class holds the PDF of a material's scattered directions by value, so
+  // that a scatter_record carries it without a heap allocation.
+ public:
+  scatter_pdf() = default;
+  scatter_pdf(const sphere_pdf& p) : dist(p) {}
+  scatter_pdf(const cosine_pdf& p) : dist(p) {}
+
+  [[nodiscard]] real value(const vec3& direction) const override {
+    return std::visit([&](const auto& p) { return p.value(direction); }, dist);
+  }
+
+  [[nodiscard]] vec3 generate() const override {
+    return std::visit([](const auto& p) { return p.generate(); }, dist);
+  }
+
+ private:
+  std::variant<sphere_pdf, cosine_pdf> dist;
+};
+
+class hittable_pdf final : public pdf {
   // The hittable_pdf class represents a probability density function for a hittable object.
  public:
   hittable_pdf(const hittable& objects, const point3& origin) : objects(objects), origin(origin) {}
 
   // Returns the PDF value for the given direction.
-  [[nodiscard]] double value(const vec3& direction) const override {
+  [[nodiscard]] real value(const vec3& direction) const override {
     return objects.pdf_value(origin, direction);
   }
 
@@ -83,14 +105,12 @@ class mixture_pdf : public pdf {
  public:
   // The mixture_pdf class represents a mixture of two probability density functions
   // It combines two PDFs with equal weights (50% each) for importance sampling
+  // The two PDFs are not copied and must outlive the mixture.
 
-  mixture_pdf(shared_ptr<pdf> p0, shared_ptr<pdf> p1) {
-    p[0] = std::move(p0);
-    p[1] = std::move(p1);
-  }
+  mixture_pdf(const pdf& p0, const pdf& p1) : p{&p0, &p1} {}
 
   // Returns the weighted sum of PDF values from both components
-  [[nodiscard]] double value(const vec3& direction) const override {
+  [[nodiscard]] real value(const vec3& direction) const override {
     return 0.5 * p[0]->value(direction) + 0.5 * p[1]->value(direction);
   }
 
@@ -103,7 +123,7 @@ class mixture_pdf : public pdf {
   }
 
  private:
-  shared_ptr<pdf> p[2];  // Array storing the two component PDFs
+  const pdf* p[2];  // Array storing the two component PDFs
 };
 
 #endif //RAYTRACINGINONEWEEKEND_INCLUDE_PDF_H_
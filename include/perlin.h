@@ -34,7 +34,7 @@ class perlin {
     perlin_generate_perm(perm_z);
   }
 
-  double noise(const point3& p) const {
+  real noise(const point3& p) const {
     auto u = p.x() - std::floor(p.x()); // Fractional part of p.x
     auto v = p.y() - std::floor(p.y()); // Fractional part of p.y
     auto w = p.z() - std::floor(p.z()); // Fractional part of p.z
@@ -65,7 +65,7 @@ class perlin {
     return perlin_interp(c, u, v, w);
   }
 
-  double turb(const point3& p, int depth) const {
+  real turb(const point3& p, int depth) const {
     // The turb function generates a sum of repeated calls to noise.
     auto accum  = 0.0;
     auto temp_p = p;
@@ -107,7 +107,7 @@ private:
     }
   }
 
-  static double perlin_interp(const vec3 c[2][2][2], double u, double v, double w) {
+  static real perlin_interp(const vec3 c[2][2][2], real u, real v, real w) {
     // Hermitian smoothing
     // Hermite polynomial: H3(x) = yo(1+2u)(1-u)^2 + y1(1-2(u-1))u^2 + mo(x-x0)(1-u)^2 + m1(x-x1)u^2
     // yo=0,y1=1,m0=m1=0(linear interpolation),x0=0,x1=1
@@ -15,12 +15,13 @@
 #include "rtweekend.h"
 
 #include "hittable.h"
+#include "material.h"
 
 class quad : public hittable {
   // The quad class represents a quadrilateral surface.
 public:
   quad(const point3& Q, const vec3& u, const vec3& v, shared_ptr<material> mat)
-      : Q(Q), u(u), v(v), mat_ptr(std::move(mat))
+      : Q(Q), u(u), v(v), mat_ptr(std::move(mat)), mat_id(mat_ptr ? mat_ptr->id() : -1)
     {
       auto n = cross(u, v);
       normal = unit_vector(n);
@@ -67,13 +68,61 @@ public:
     // Ray hits the 2D shape; set the hit rest of the hit record and return true.
     rec.t     = t;
     rec.p     = intersection;
-    rec.mat   = mat_ptr;
+    rec.mat_id = mat_id;
     rec.set_face_normal(r, normal);
 
     return true;
   }
 
-  virtual bool is_interior(double alpha, double beta, hit_record& rec) const {
+  lane_mask hit_packet(ray_packet& packet, lane_mask mask, hit_record* recs) const override {
+    // The same test as hit, for all lanes of a packet at once. Only the interior test of the
+    // lanes that hit the plane is left to the (virtual) is_interior.
+    real ts[packet_width], alphas[packet_width], betas[packet_width];
+    bool in_plane[packet_width];
+
+    for (int lane = 0; lane < packet_width; ++lane) {
+      auto dx = packet.dx[lane], dy = packet.dy[lane], dz = packet.dz[lane];
+      auto denom = normal.x()*dx + normal.y()*dy + normal.z()*dz;
+      auto t = (D - (normal.x()*packet.ox[lane] + normal.y()*packet.oy[lane]
+                     + normal.z()*packet.oz[lane])) / denom;
+
+      // planar_hitpt_vector = r.at(t) - Q
+      auto px = (packet.ox[lane] + t*dx) - Q.x();
+      auto py = (packet.oy[lane] + t*dy) - Q.y();
+      auto pz = (packet.oz[lane] + t*dz) - Q.z();
+
+      // alpha = dot(w, cross(p, v)), beta = dot(w, cross(u, p))
+      alphas[lane] = w.x()*(py*v.z() - pz*v.y()) + w.y()*(pz*v.x() - px*v.z())
+                   + w.z()*(px*v.y() - py*v.x());
+      betas[lane] = w.x()*(u.y()*pz - u.z()*py) + w.y()*(u.z()*px - u.x()*pz)
+                  + w.z()*(u.x()*py - u.y()*px);
+
+      ts[lane] = t;
+      in_plane[lane] = !(std::fabs(denom) < 1e-8) && packet.t_min <= t && t <= packet.t_max[lane];
+    }
+
+    lane_mask hits = 0;
+    for (int lane = 0; lane < packet_width; ++lane) {
+      if (!(mask & (1u << lane)) || !in_plane[lane])
+        continue;
+
+      auto& rec = recs[lane];
+      if (!is_interior(alphas[lane], betas[lane], rec))
+        continue;
+
+      const ray& r = packet.rays[lane];
+      rec.t     = ts[lane];
+      rec.p     = r.at(ts[lane]);
+      rec.mat_id = mat_id;
+      rec.set_face_normal(r, normal);
+
+      packet.t_max[lane] = ts[lane];
+      hits |= 1u << lane;
+    }
+    return hits;
+  }
+
+  virtual bool is_interior(real alpha, real beta, hit_record& rec) const {
     interval unit_interval(0, 1);
     // Given the hit point in plane coordinates, return false if it lies outside the
     // primitive, otherwise set the hit record UV coordinates and return true.
@@ -86,7 +135,7 @@ public:
     return true;
   }
 
-  [[nodiscard]] double pdf_value(const point3& origin, const vec3& direction) const override {
+  [[nodiscard]] real pdf_value(const point3& origin, const vec3& direction) const override {
     hit_record rec;
     // Try to hit the surface from the given origin along the given direction
     if (!hit(ray(origin, direction), interval(0.001, infinity), rec))
@@ -113,10 +162,11 @@ public:
   vec3    v;      // The second axis of the quadrilateral surface.
   vec3    w;      // w = n/n·n
   vec3    normal; // The normal of the quadrilateral surface.
-  double  D;      // Ax + By + Cz = D
-  double  area;   // The surface area of the quadrilateral, calculated as the length of the cross product of u and v vectors
+  real    D;      // Ax + By + Cz = D
+  real    area;   // The surface area of the quadrilateral, calculated as the length of the cross product of u and v vectors
   AABB    bbox;   // The bounding box of the quadrilateral surface.
   shared_ptr<material> mat_ptr; // The material of the quadrilateral surface.
+  int     mat_id; // The index of mat_ptr in the material table (-1 without a material).
 };
 
 inline shared_ptr<hittable_list> box(const point3& a, const point3& b, const shared_ptr<material>& mat)
@@ -150,7 +200,7 @@ class tri : public quad {
         : quad(o, aa, ab, std::move(m))
         {}
 
-    virtual bool is_interior(double a, double b, hit_record& rec) const override {
+    virtual bool is_interior(real a, real b, hit_record& rec) const override {
       if ((a < 0) || (b < 0) || (a + b > 1))
         return false;
 
@@ -166,14 +216,18 @@ class ellipse : public quad {
     ellipse(
         const point3& center, const vec3& side_A, const vec3& side_B, shared_ptr<material> m
         ) : quad(center, side_A, side_B, std::move(m))
-        {}  // The ellipse is a quad with a center and two axes.
+        {
+      // The ellipse is a quad with a center and two axes. The quad constructor could only
+      // call quad::set_bounding_box, so the box is set again here.
+      set_bounding_box();
+    }
 
     virtual void set_bounding_box() override {
       // Compute the bounding box of the ellipse
       bbox = AABB(Q - u - v, Q + u + v);
     }
 
-    virtual bool is_interior(double a, double b, hit_record& rec) const override {
+    virtual bool is_interior(real a, real b, hit_record& rec) const override {
       if ((a * a + b * b) > 1)
         return false;
 
@@ -187,17 +241,20 @@ class annulus : public quad {
   // The annulus class represents an annular surface.
  public:
   annulus(
-      const point3& center, const vec3& side_A, const vec3& side_B, double _inner,
+      const point3& center, const vec3& side_A, const vec3& side_B, real _inner,
       shared_ptr<material> m)
       : quad(center, side_A, side_B, std::move(m)), inner(_inner)
-      {}
+      {
+    // The quad constructor could only call quad::set_bounding_box.
+    set_bounding_box();
+  }
 
   virtual void set_bounding_box() override {
     // Compute the bounding box of the annulus.
     bbox = AABB(Q - u - v, Q + u + v);
   }
 
-  virtual bool is_interior(double a, double b, hit_record& rec) const override {
+  virtual bool is_interior(real a, real b, hit_record& rec) const override {
     if ((a * a + b * b) > 1 || (a * a + b * b) < inner * inner)
       return false;
 
@@ -207,6 +264,6 @@ class annulus : public quad {
   }
 
  private:
-  double inner; // The inner radius of the annulus.
+  real    inner;  // The inner radius of the annulus.
 };
 #endif //RAYTRACINGINONEWEEKEND_INCLUDE_QUAD_H_
@@ -8,7 +8,8 @@
  * @File: ray.h
  * @Software: CLion
  * @Project: RayTracingInOneWeekend
- * @Description:
+ * @Description: A ray also caches the reciprocal of its direction and the sign of every
+ * component, which the slab tests of bounding boxes use for every box a ray meets.
  */
 
 #ifndef RAYTRACINGINONEWEEKEND_RAY_H
@@ -16,28 +17,64 @@
 
 #include "rtweekend.h"
 
-class ray {
+#include <cstdint>
+#include <type_traits>
+
+template <typename T>
+class basic_ray {
 public:
-    ray() = default;
+    basic_ray() = default;
+
+    basic_ray(const basic_vec3<T>& origin, const basic_vec3<T>& direction, T time)
+        : orig(origin), dir(direction), tm(time),
+          inv_dir(T(1) / direction.x(), T(1) / direction.y(), T(1) / direction.z()) {
+        for (int axis = 0; axis < 3; ++axis)
+            signs[axis] = inv_dir[axis] < 0;
+    }
+
+    basic_ray(const basic_vec3<T>& origin, const basic_vec3<T>& direction)
+        : basic_ray(origin, direction, 0) {}
 
-    ray(const point3& origin, const vec3& direction, double time)
-        : orig(origin), dir(direction), tm(time) {}
+    [[nodiscard]] const basic_vec3<T>& origin() const { return orig; }
+    [[nodiscard]] const basic_vec3<T>& direction() const { return dir; }
 
-    ray(const point3& origin, const vec3& direction)
-        : ray(origin, direction, 0) {}
+    [[nodiscard]] T time() const { return tm; }
 
-    [[nodiscard]] const point3& origin() const { return orig; }
-    [[nodiscard]] const vec3& direction() const { return dir; }
+    // 1 / direction per component (infinite for a zero component, signed like the zero).
+    [[nodiscard]] const basic_vec3<T>& inv_direction() const { return inv_dir; }
 
-    [[nodiscard]] double time() const { return tm; }
+    // 1 if the direction points down the given axis, else 0.
+    [[nodiscard]] int sign(int axis) const { return signs[axis]; }
 
-    [[nodiscard]] point3 at(double t) const {
+    [[nodiscard]] basic_vec3<T> at(T t) const {
         return orig + t*dir;
     }
 
 private:
-    point3  orig;
-    vec3    dir;
-    double  tm{};
+    basic_vec3<T>  orig;
+    basic_vec3<T>  dir;
+    T              tm{};
+    basic_vec3<T>  inv_dir;
+    uint8_t        signs[3]{};
 };
+
+using ray = basic_ray<real>;
+
+template <typename T>
+inline basic_vec3<T> offset_ray_origin(const basic_vec3<T>& p, const basic_vec3<T>& normal,
+                                       const basic_vec3<T>& direction) {
+    // Returns the origin of a ray leaving the surface point p in the given direction. In
+    // float the rounding error of p grows with its magnitude and soon exceeds the fixed
+    // 0.001 of the ray intervals, so the origin is pushed off the surface along the normal,
+    // to the side the ray leaves on, by an amount that scales with p. Doubles are exact
+    // enough for the fixed interval alone and keep the point unchanged.
+    if constexpr (std::is_same_v<T, double>) {
+        return p;
+    } else {
+        auto magnitude = std::max({std::fabs(p.x()), std::fabs(p.y()), std::fabs(p.z())});
+        auto offset = (1 + magnitude) * T(1.0 / 65536);
+        return dot(normal, direction) < 0 ? p - offset * normal : p + offset * normal;
+    }
+}
+
 #endif //RAYTRACINGINONEWEEKEND_RAY_H
@@ -0,0 +1,188 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: ray_packet.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: The ray_packet class bundles a group of coherent rays (e.g. the camera rays of
+ * one pixel) so that they can traverse the BVH together. The rays are stored both as ray
+ * objects and as separate coordinate arrays, which the packet tests load into the lane types
+ * of simd.h. Lanes are selected by bit masks, one bit per lane.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_RAY_PACKET_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_RAY_PACKET_H_
+
+#include "rtweekend.h"
+
+#include "AABB.h"
+#include "simd.h"
+
+#ifndef RTW_PACKET_WIDTH
+#define RTW_PACKET_WIDTH 8
+#endif
+
+constexpr int packet_width = RTW_PACKET_WIDTH;      // Rays per packet
+constexpr int packet_min_lanes = packet_width / 4;  // Below this the lanes are traced alone
+
+static_assert(packet_width >= 1 && packet_width <= 32, "packet lanes must fit an unsigned mask");
+
+using lane_mask = unsigned;
+
+inline int lane_count(lane_mask mask) {
+  // Number of lanes set in a mask.
+  int count = 0;
+  for (; mask; mask &= mask - 1)
+    ++count;
+  return count;
+}
+
+class ray_packet {
+ public:
+  ray       rays[packet_width];   // The rays, for the lanes that are traced alone
+  pcg32     rngs[packet_width];   // Random stream of every lane (some hits draw from it)
+  real      ox[packet_width], oy[packet_width], oz[packet_width];  // Origins
+  real      dx[packet_width], dy[packet_width], dz[packet_width];  // Directions
+  real      time[packet_width];   // Ray times
+  real      t_min = 0.001;        // Start of every lane's ray interval
+  real      t_max[packet_width];  // End of every lane's ray interval, i.e. the closest hit
+  int       size = 0;             // Number of lanes in use
+
+  void clear() {
+    // Empty the packet so that it can be filled again.
+    size = 0;
+  }
+
+  void add(const ray& r, const pcg32& rng) {
+    // Append a ray to the packet.
+    int lane = size++;
+    rays[lane] = r;
+    rngs[lane] = rng;
+    ox[lane] = r.origin().x(); oy[lane] = r.origin().y(); oz[lane] = r.origin().z();
+    dx[lane] = r.direction().x(); dy[lane] = r.direction().y(); dz[lane] = r.direction().z();
+    time[lane] = r.time();
+    t_max[lane] = infinity;
+  }
+
+  void finalize() {
+    // Pad the unused lanes with copies of the first ray, and compute the reciprocal
+    // directions and the bounds of the packet used by the frustum test.
+    for (int lane = size; lane < packet_width; ++lane) {
+      ox[lane] = ox[0]; oy[lane] = oy[0]; oz[lane] = oz[0];
+      dx[lane] = dx[0]; dy[lane] = dy[0]; dz[lane] = dz[0];
+      time[lane] = time[0];
+      t_max[lane] = infinity;
+    }
+
+    const real* origins[3] = {ox, oy, oz};
+    const real* directions[3] = {dx, dy, dz};
+    coherent = size > 0;
+    finite_inv = true;
+
+    for (int axis = 0; axis < 3; ++axis) {
+      real* inv = inv_dir[axis];
+      for (int lane = 0; lane < packet_width; ++lane)
+        inv[lane] = 1.0 / directions[axis][lane];
+
+      origin_bounds[axis] = interval(*std::min_element(origins[axis], origins[axis] + packet_width),
+                                     *std::max_element(origins[axis], origins[axis] + packet_width));
+      inv_dir_bounds[axis] = interval(*std::min_element(inv, inv + packet_width),
+                                      *std::max_element(inv, inv + packet_width));
+      if (!std::isfinite(inv_dir_bounds[axis].min) || !std::isfinite(inv_dir_bounds[axis].max))
+        finite_inv = false;
+
+      // The frustum test needs the directions of all lanes on the same side of every axis.
+      if (!(inv_dir_bounds[axis].min > 0 || inv_dir_bounds[axis].max < 0)
+          || !std::isfinite(inv_dir_bounds[axis].min) || !std::isfinite(inv_dir_bounds[axis].max))
+        coherent = false;
+    }
+  }
+
+  [[nodiscard]] lane_mask full_mask() const {
+    return size >= 32 ? ~0u : (1u << size) - 1;
+  }
+
+  [[nodiscard]] bool frustum_misses(const AABB& box, lane_mask mask) const {
+    // Returns true if no ray of the packet can hit the box. The slab distances of all lanes
+    // are bounded at once with interval arithmetic on the packet's origin and reciprocal
+    // direction bounds, so one test culls the node for the whole packet.
+    if (!coherent)
+      return false;
+
+    real far_limit = t_min;
+    for (int lane = 0; lane < packet_width; ++lane)
+      if (mask & (1u << lane))
+        far_limit = std::max(far_limit, t_max[lane]);
+
+    real near = t_min, far = far_limit;
+    for (int axis = 0; axis < 3; ++axis) {
+      const interval& ax = box.axis_interval(axis);
+      const interval& o = origin_bounds[axis];
+      const interval& inv = inv_dir_bounds[axis];
+
+      // Near and far slab planes, depending on the (shared) sign of the direction.
+      real lo = inv.min > 0 ? ax.min : ax.max;
+      real hi = inv.min > 0 ? ax.max : ax.min;
+
+      near = std::max(near, product_min(lo - o.max, lo - o.min, inv));
+      far = std::min(far, product_max(hi - o.max, hi - o.min, inv));
+      if (far < near)
+        return true;
+    }
+    return false;
+  }
+
+  [[nodiscard]] lane_mask hit_mask(const AABB& box, lane_mask mask) const {
+    // Slab test of every lane against the box, with the same results as AABB::hit.
+    // Returns the lanes of the mask whose ray hits the box.
+    using lanes = basic_lanes<real, packet_width>;
+    const real* origins[3] = {ox, oy, oz};
+
+    lanes lo(t_min);
+    lanes hi = lanes::load(t_max);
+
+    for (int axis = 0; axis < 3; ++axis) {
+      const interval& ax = box.axis_interval(axis);
+      auto o = lanes::load(origins[axis]);
+      auto inv = lanes::load(inv_dir[axis]);
+
+      auto t0 = (lanes(ax.min) - o) * inv;
+      auto t1 = (lanes(ax.max) - o) * inv;
+      if (finite_inv) {
+        // With finite reciprocals the nearer distance is the one to the near plane.
+        lo = max(min(t0, t1), lo);
+        hi = min(max(t0, t1), hi);
+      } else {
+        // A zero direction can make a distance NaN: pick the near and far plane of every
+        // lane by the sign of its direction, as AABB::hit does.
+        auto backwards = inv < lanes(0);
+        lo = max(select(backwards, t1, t0), lo);
+        hi = min(select(backwards, t0, t1), hi);
+      }
+    }
+
+    return (hi > lo).bits() & mask;
+  }
+
+ private:
+  real      inv_dir[3][packet_width];  // Reciprocal directions, per axis
+  interval  origin_bounds[3];          // Bounds of the lanes' origins, per axis
+  interval  inv_dir_bounds[3];         // Bounds of the lanes' reciprocal directions, per axis
+  bool      coherent = false;          // Whether the frustum test may be used
+  bool      finite_inv = false;        // Whether no lane has a zero direction component
+
+  static real product_min(real a, real b, const interval& inv) {
+    // Lower bound of x * y for x between a and b and y in inv.
+    return std::min(std::min(a * inv.min, a * inv.max), std::min(b * inv.min, b * inv.max));
+  }
+
+  static real product_max(real a, real b, const interval& inv) {
+    // Upper bound of x * y for x between a and b and y in inv.
+    return std::max(std::max(a * inv.min, a * inv.max), std::max(b * inv.min, b * inv.max));
+  }
+};
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_RAY_PACKET_H_
@@ -0,0 +1,90 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: rng.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: Small, fast random number generators for the renderer.
+ * pcg32 is the PCG-XSH-RR generator by M.E. O'Neill: 16 bytes of state, one multiply per
+ * number, and 2^63 independent streams selected by the increment. Every thread owns one
+ * generator (thread_rng), so the hot path never touches shared mutable state, and a
+ * generator can be reseeded from a (pixel, sample) key to make a sample reproducible.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_RNG_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_RNG_H_
+
+#include <cstdint>
+
+inline uint64_t mix_bits(uint64_t v) {
+  // SplitMix64 finalizer: scrambles a key so that neighbouring keys give unrelated seeds.
+  v ^= v >> 30;
+  v *= 0xbf58476d1ce4e5b9ULL;
+  v ^= v >> 27;
+  v *= 0x94d049bb133111ebULL;
+  v ^= v >> 31;
+  return v;
+}
+
+class pcg32 {
+ public:
+  pcg32() { seed(default_seed, default_stream); }
+
+  pcg32(uint64_t seed_value, uint64_t stream) { seed(seed_value, stream); }
+
+  void seed(uint64_t seed_value, uint64_t stream = default_stream) {
+    // Restart the sequence at the given seed on the given stream.
+    state = 0;
+    inc = (stream << 1u) | 1u;
+    next_uint();
+    state += seed_value;
+    next_uint();
+  }
+
+  void seed_key(uint64_t key0, uint64_t key1) {
+    // Derive seed and stream from a two-part key, e.g. (pixel index, sample index).
+    seed(mix_bits(key0 ^ mix_bits(key1)), mix_bits(key1 + 0x9e3779b97f4a7c15ULL));
+  }
+
+  uint32_t next_uint() {
+    // Returns a uniformly distributed 32-bit integer.
+    uint64_t old = state;
+    state = old * 6364136223846793005ULL + inc;
+    auto xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+    auto rot = static_cast<uint32_t>(old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((~rot + 1u) & 31u));
+  }
+
+  uint32_t next_uint(uint32_t bound) {
+    // Returns a uniformly distributed integer in [0, bound), without modulo bias.
+    uint32_t threshold = (~bound + 1u) % bound;
+    while (true) {
+      uint32_t r = next_uint();
+      if (r >= threshold)
+        return r % bound;
+    }
+  }
+
+  double next_double() {
+    // Returns a random real in [0,1) with 32 bits of randomness.
+    return next_uint() * 0x1p-32;
+  }
+
+  static constexpr uint64_t default_seed   = 0x853c49e6748fea9bULL;
+  static constexpr uint64_t default_stream = 0xda3e39cb94b95bdbULL >> 1u;
+
+ private:
+  uint64_t state{};   // Current position in the sequence
+  uint64_t inc{};     // Stream selector, always odd
+};
+
+inline pcg32& thread_rng() {
+  // Returns the generator of the calling thread.
+  thread_local pcg32 generator;
+  return generator;
+}
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_RNG_H_
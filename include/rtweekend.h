@@ -20,9 +20,18 @@
 #include <iostream>
 #include <limits>
 #include <memory>
-#include <random>
 #include <utility>
 
+#include "rng.h"
+
+// Scalar type of the math core (vec3, ray, interval, AABB, hit records): double by default,
+// float when built with RTW_USE_FLOAT.
+#ifdef RTW_USE_FLOAT
+using real = float;
+#else
+using real = double;
+#endif
+
 // C++ Std Usings
 
 using std::make_shared;
@@ -39,11 +48,14 @@ inline double degrees_to_radians(double degrees) {
     return degrees * pi  / 180.0;
 }
 
+inline void seed_random(uint64_t seed, uint64_t stream = pcg32::default_stream) {
+    // Restarts the calling thread's random sequence from the given seed and stream.
+    thread_rng().seed(seed, stream);
+}
+
 inline double random_double() {
     // Returns a random real in [0,1).
-    static std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    static std::mt19937 generator;
-    return distribution(generator);
+    return thread_rng().next_double();
 }
 
 inline double random_double(double min, double max) {
@@ -53,7 +65,7 @@ inline double random_double(double min, double max) {
 
 inline int random_int(int min, int max) {
     // Returns a random integer in [min,max].
-    return int(random_double(min,max+1));
+    return min + static_cast<int>(thread_rng().next_uint(static_cast<uint32_t>(max - min + 1)));
 }
 
 // Common Headers
@@ -0,0 +1,578 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: scenes.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: The scenes of the book series. Every function builds the world, the light
+ * sources used for importance sampling and the camera, so that main.cpp and the benchmarks
+ * render exactly the same scenes. The BVHs of a scene are built with the options it is given.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_SCENES_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_SCENES_H_
+
+#include "rtweekend.h"
+
+#include "bvh.h"
+#include "camera.h"
+#include "constant_medium.h"
+#include "hittable_list.h"
+#include "instance.h"
+#include "material.h"
+#include "quad.h"
+#include "sphere.h"
+#include "texture.h"
+
+struct scene {
+  // A scene bundles the world, the light sources used for importance sampling and the camera.
+  hittable_list world;
+  hittable_list lights;
+  camera        cam;
+};
+
+inline scene bouncing_spheres(const bvh_build_options& bvh_options = {}) {
+  // World
+  hittable_list world;
+
+  // Ground Sphere
+  auto ground_material = make_shared<lambertian>(
+      color(0.5, 0.5, 0.5));
+  world.add(make_shared<sphere>(
+      point3(0, -1000, 0), 1000, ground_material));
+
+  // Random Spheres
+  for (int a = -11; a < 11; ++a) {
+    for (int b = -11; b < 11; ++b) {
+      auto choose_mat = random_double();
+      point3 center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
+
+      if ((center - point3(4, 0.2, 0)).length() > 0.9) {
+        shared_ptr<material> sphere_material;
+
+        if (choose_mat < 0.8) {
+          // Diffuse
+          auto albedo = color::random() * color::random();
+          sphere_material = make_shared<lambertian>(albedo);
+          // Sphere movement
+          auto center2 = center + vec3(0, random_double(0, 0.5), 0);
+          world.add(make_shared<sphere>(center, center2,
+                                        0.2, sphere_material));
+        } else if (choose_mat < 0.95) {
+          // Metal
+          auto albedo = color::random(0.5, 1);
+          auto fuzz = random_double(0, 0.5);
+          sphere_material = make_shared<metal>(albedo, fuzz);
+          world.add(make_shared<sphere>(center, 0.2, sphere_material));
+        } else {
+          // Glass
+          sphere_material = make_shared<dielectric>(1.5);
+          world.add(make_shared<sphere>(center, 0.2, sphere_material));
+        }
+      }
+    }
+  }
+
+  // Three Large Spheres
+  auto material1 = make_shared<dielectric>(1.5);
+  world.add(make_shared<sphere>(point3(0, 1, 0),
+                                1.0, material1));
+
+  auto material2 = make_shared<lambertian>(
+      color(0.4, 0.2, 0.1));
+  world.add(make_shared<sphere>(point3(-4, 1, 0),
+                                1.0, material2));
+
+  auto material3 = make_shared<metal>(
+      color(0.7, 0.6, 0.5), 0.0);
+  world.add(make_shared<sphere>(point3(4, 1, 0),
+                                1.0, material3));
+
+  // BVH Acceleration
+  world = hittable_list(make_shared<bvh_node>(world, bvh_options));
+
+  // Light source
+  auto empty_material = shared_ptr<material>();
+  hittable_list light(make_shared<quad>(point3(0, 0, 0),vec3(675, 0, 0),
+                                        vec3(0, 1200, 0),empty_material));
+
+  // Camera
+  camera cam;
+
+  cam.aspect_ratio = 16.0 / 9.0;
+  cam.image_width = 1200;
+  cam.samples_per_pixel = 10000;
+  cam.max_depth = 50;
+  cam.background_color  = color(0.70, 0.80, 1.00);
+
+  cam.vfov = 20;
+  cam.lookfrom = point3(13, 2, 3);
+  cam.lookat = point3(0, 0, 0);
+  cam.vup = vec3(0, 1, 0);
+
+  cam.defocus_angle = 0.6;
+  cam.focus_dist = 10.0;
+
+  return {world, light, cam};
+}
+
+inline scene checkered_spheres(const bvh_build_options& bvh_options = {}) {
+  // World
+  hittable_list world;
+
+  // Checkerboard Ground
+  auto checker = make_shared<checker_texture>(0.32,
+                                              color(0.2, 0.3, 0.1),
+                                              color(0.9, 0.9, 0.9));
+  world.add(make_shared<sphere>(point3(0,-10,0),
+                                10, make_shared<lambertian>(checker)));
+  world.add(make_shared<sphere>(point3(0,  10, 0),
+                                10, make_shared<lambertian>(checker)));
+
+
+
+  // BVH Acceleration
+  world = hittable_list(make_shared<bvh_node>(world, bvh_options));
+
+  // Camera
+  camera cam;
+
+  cam.aspect_ratio        = 16.0 / 9.0;
+  cam.image_width         = 1200;
+  cam.samples_per_pixel   = 100;
+  cam.max_depth           = 50;
+  cam.background_color  = color(0.70, 0.80, 1.00);
+
+  cam.vfov                = 20;
+  cam.lookfrom            = point3(13, 2, 3);
+  cam.lookat              = point3(0, 0, 0);
+  cam.vup                 = vec3(0, 1, 0);
+
+  cam.defocus_angle       = 0;
+
+
+  return {world, world, cam};
+}
+
+inline scene earth(const bvh_build_options& = {}) {
+  // Globe
+  auto earth_texture = make_shared<image_texture>(
+      "../assets/textures/earthmap.jpg");
+  auto earth_surface = make_shared<lambertian>(earth_texture);
+  auto globe = make_shared<sphere>(
+      point3(0, 0, 0), 2, earth_surface);
+
+  // Camera
+  camera cam;
+
+  cam.aspect_ratio      = 16.0 / 9.0;
+  cam.image_width       = 1200;
+  cam.samples_per_pixel = 100;
+  cam.max_depth         = 50;
+  cam.background_color  = color(0.70, 0.80, 1.00);
+
+  cam.vfov              = 20;
+  cam.lookfrom          = point3(0, 0, 12);
+  cam.lookat            = point3 (0, 0, 0);
+  cam.vup               = vec3(0, 1, 0);
+
+  cam.defocus_angle     = 0;
+
+  return {hittable_list(globe), hittable_list(globe), cam};
+}
+
+inline scene perlin_spheres(const bvh_build_options& bvh_options = {}) {
+  // World
+  hittable_list world;
+
+  auto pertext = make_shared<noise_texture>(4);
+  world.add(make_shared<sphere>(
+      point3(0,-1000,0), 1000, make_shared<lambertian>(pertext)));
+  world.add(make_shared<sphere>(
+      point3(0,2,0), 2, make_shared<lambertian>(pertext)));
+
+  // BVH Acceleration
+  world = hittable_list(make_shared<bvh_node>(world, bvh_options));
+
+  // Camera
+  camera cam;
+  cam.aspect_ratio      = 16.0 / 9.0;
+  cam.image_width       = 1200;
+  cam.samples_per_pixel = 100;
+  cam.max_depth         = 50;
+  cam.background_color  = color(0.70, 0.80, 1.00);
+
+  cam.vfov              = 20;
+  cam.lookfrom          = point3(13, 2, 3);
+  cam.lookat            = point3 (0, 0, 0);
+  cam.vup               = vec3(0, 1, 0);
+
+  cam.defocus_angle     = 0;
+
+  return {world, world, cam};
+}
+
+inline scene quads(const bvh_build_options& bvh_options = {}) {
+  // World
+  hittable_list world;
+
+  // Materials
+  auto left_red     = make_shared<lambertian>(color(1.0, 0.2, 0.2));
+  auto back_green   = make_shared<lambertian>(color(0.2, 1.0, 0.2));
+  auto right_blue   = make_shared<lambertian>(color(0.2, 0.2, 1.0));
+  auto upper_orange = make_shared<lambertian>(color(1.0, 0.5, 0.0));
+  auto lower_teal   = make_shared<lambertian>(color(0.2, 0.8, 0.8));
+
+  // Quads
+  world.add(make_shared<quad>(point3(-3, -2, 5), vec3(0, 0, -4),
+                              vec3(0, 4, 0), left_red));
+  world.add(make_shared<quad>(point3(-2, -2, 0), vec3(4, 0, 0),
+                              vec3(0, 4, 0), back_green));
+  world.add(make_shared<quad>(point3(3, -2, 1), vec3(0, 0, 4),
+                              vec3(0, 4, 0), right_blue));
+  world.add(make_shared<quad>(point3(-2, 3, 1), vec3(4, 0, 0),
+                              vec3(0, 0, 4), upper_orange));
+  world.add(make_shared<quad>(point3(-2, -3, 5), vec3(4, 0, 0),
+                              vec3(0, 0, -4), lower_teal));
+
+  // BVH Acceleration
+  world = hittable_list(make_shared<bvh_node>(world, bvh_options));
+
+  // Camera
+  camera cam;
+  cam.aspect_ratio      = 1.0;
+  cam.image_width       = 1200;
+  cam.samples_per_pixel = 100;
+  cam.max_depth         = 50;
+  cam.background_color  = color(0.70, 0.80, 1.00);
+
+  cam.vfov              = 80;
+  cam.lookfrom          = point3(0, 0, 9);
+  cam.lookat            = point3 (0, 0, 0);
+  cam.vup               = vec3(0, 1, 0);
+
+  cam.defocus_angle     = 0;
+
+  return {world, world, cam};
+}
+
+inline scene quad_test(const bvh_build_options& bvh_options = {}) {
+  // World
+  hittable_list world;
+
+  // Materials
+  auto red   = make_shared<lambertian>(color(0.65, 0.05, 0.05));
+  auto green = make_shared<lambertian>(color(0.12, 0.45, 0.15));
+  auto white = make_shared<lambertian>(color(0.73, 0.73, 0.73));
+  auto light = make_shared<diffuse_light>(color(15, 15, 15));
+
+  // Quads
+  world.add(make_shared<quad>(point3(-2,-1,0), vec3(4,0,0),
+                              vec3(0,2,0), light));
+  world.add(make_shared<tri>(point3(3, 2, 0), vec3(4, 0, 0),
+                             vec3(0, 2, 0), light));
+  world.add(make_shared<ellipse>(point3(2, -5, 0), vec3(4, 0, 0),
+                                 vec3(0, -2, 0), light));
+  world.add(make_shared<annulus>(point3(5, 5, 0), vec3(2, 0, 0),
+                                 vec3(0, 1, 0), 0.60, light));
+
+
+  // BVH Acceleration
+  world = hittable_list(make_shared<bvh_node>(world, bvh_options));
+
+  // Camera
+  camera cam;
+
+  cam.aspect_ratio      = 1.0;
+  cam.image_width       = 600;
+  cam.samples_per_pixel = 200;
+  cam.max_depth         = 50;
+  cam.background_color  = color(0, 0, 0);
+
+  cam.vfov              = 80;
+  cam.lookfrom          = point3(0, 0, 9);
+  cam.lookat            = point3(0, 0, 0);
+  cam.vup               = vec3(0, 1, 0);
+
+  cam.defocus_angle     = 0;
+
+  return {world, world, cam};
+}
+
+inline scene simple_light(const bvh_build_options& bvh_options = {}) {
+  // World
+  hittable_list world;
+
+  // Materials
+  auto pertext = make_shared<noise_texture>(4);
+  world.add(make_shared<sphere>(
+      point3(0,-1000,0), 1000, make_shared<lambertian>(pertext)));
+  world.add(make_shared<sphere>(
+      point3(0,2,0), 2, make_shared<lambertian>(pertext)));
+
+  auto difflight = make_shared<diffuse_light>(color(4,4,4));
+  world.add(make_shared<quad>(point3(3,1,-2), vec3(2, 0, 0),
+                              vec3(0, 2, 0), difflight));
+
+  // BVH Acceleration
+  world = hittable_list(make_shared<bvh_node>(world, bvh_options));
+
+  // Camera
+  camera cam;
+  cam.aspect_ratio      = 16.0 / 9.0;
+  cam.image_width       = 1200;
+  cam.samples_per_pixel = 100;
+  cam.max_depth         = 50;
+  cam.background_color  = color(0, 0, 0);
+
+  cam.vfov              = 20;
+  cam.lookfrom          = point3(26, 3, 6);
+  cam.lookat            = point3 (0, 2, 0);
+  cam.vup               = vec3(0, 1, 0);
+
+  cam.defocus_angle     = 0;
+
+  return {world, world, cam};
+}
+
+inline scene cornell_box(const bvh_build_options& bvh_options = {}) {
+  // World
+  hittable_list world;
+
+  // Materials
+  auto red   = make_shared<lambertian>(color(.65, .05, .05));
+  auto white = make_shared<lambertian>(color(.73, .73, .73));
+  auto green = make_shared<lambertian>(color(.12, .45, .15));
+  auto light = make_shared<diffuse_light>(color(15, 15, 15));
+
+  // Cornell Box
+  world.add(make_shared<quad>(point3(555, 0, 0), vec3(0, 0, 555),
+                              vec3(0, 555, 0), green));
+  world.add(make_shared<quad>(point3(0, 0, 0), vec3(0, 555, 0),
+                              vec3(0, 0, 555), red));
+  world.add(make_shared<quad>(point3(343, 554, 332), vec3(-130, 0, 0),
+                              vec3(0, 0, -105), light));
+  world.add(make_shared<quad>(point3(0, 0, 0), vec3(555, 0, 0),
+                              vec3(0, 0, 555), white)); // bottom
+  world.add(make_shared<quad>(point3(555, 555, 555), vec3(-555, 0, 0),
+                              vec3(0, 0, -555), white)); // top
+  world.add(make_shared<quad>(point3(0, 0, 555), vec3(555, 0, 0),
+                              vec3(0, 555, 0), white)); // back
+
+  // boxes
+  shared_ptr<hittable> box1 = box(point3(0, 0, 0),
+                                  point3(165, 330, 165), white);
+  box1 = make_shared<rotate_y>(box1, 15);
+  box1 = make_shared<translate>(box1, vec3(265, 0, 295));
+  world.add(box1);
+
+  // Glass Sphere
+  auto glass = make_shared<dielectric>(1.5);
+  world.add(make_shared<sphere>(point3(190, 90, 190),
+                                90, glass));
+
+  // Light Sources
+  auto empty_material = shared_ptr<material>();
+  hittable_list lights;
+  lights.add(make_shared<quad>(point3(343, 554, 332),
+                               vec3(-130, 0, 0),vec3(0, 0, -105),
+                               empty_material));
+  lights.add(make_shared<sphere>(point3(190, 90, 190),
+                                 90, empty_material));
+
+  // BVH Acceleration
+  world = hittable_list(make_shared<bvh_node>(world, bvh_options));
+
+  // Camera
+  camera cam;
+
+  cam.aspect_ratio      = 1.0;
+  cam.image_width       = 600;
+  cam.samples_per_pixel = 1000;
+  cam.max_depth         = 50;
+  cam.background_color  = color(0, 0, 0);
+
+  cam.vfov              = 40;
+  cam.lookfrom          = point3(278, 278, -800);
+  cam.lookat            = point3 (278, 278, 0);
+  cam.vup               = vec3(0, 1, 0);
+
+  cam.defocus_angle     = 0;
+
+  return {world, lights, cam};
+}
+
+inline scene cornell_smoke(const bvh_build_options& bvh_options = {}) {
+  // World
+  hittable_list world;
+
+  // Materials
+  auto red    = make_shared<lambertian>(color (.65, .05, .05));
+  auto white  = make_shared<lambertian>(color (.73, .73, .73));
+  auto green  = make_shared<lambertian>(color (.12, .45, .15));
+  auto light = make_shared<diffuse_light>(color(7, 7, 7));
+
+  // Cornell Box
+  world.add(make_shared<quad>(point3(555, 0, 0), vec3(0, 0, 555),
+                              vec3(0, 555, 0), green));
+  world.add(make_shared<quad>(point3(0, 0, 0), vec3(0, 555, 0),
+                              vec3(0, 0, 555), red));
+  world.add(make_shared<quad>(point3(113, 554, 127), vec3(330, 0, 0),
+                              vec3(0, 0, 305), light));
+  world.add(make_shared<quad>(point3(0, 0, 0), vec3(555, 0, 0),
+                              vec3(0, 0, 555), white)); // bottom
+  world.add(make_shared<quad>(point3(555, 555, 555), vec3(-555, 0, 0),
+                              vec3(0, 0, -555), white)); // top
+  world.add(make_shared<quad>(point3(0, 0, 555), vec3(555, 0, 0),
+                              vec3(0, 555, 0), white)); // back
+
+  // boxes
+  shared_ptr<material> aluminum = make_shared<metal>(color(0.8, 0.85, 0.88), 0.0);
+  shared_ptr<hittable> box1 = box(point3(0, 0, 0),
+                                  point3(165, 330, 165), aluminum);
+  box1 = make_shared<rotate_y>(box1, 15);
+  box1 = make_shared<translate>(box1, vec3(265, 0, 295));
+
+  shared_ptr<hittable> box2 = box(point3(0, 0, 0),
+                                  point3(165, 165, 165), white);
+  box2 = make_shared<rotate_y>(box2, -18);
+  box2 = make_shared<translate>(box2, vec3(130, 0, 65));
+
+  world.add(make_shared<constant_medium>(box1, 0.01,
+                                         color(0, 0, 0)));
+  world.add(make_shared<constant_medium>(box2, 0.01,
+                                         color(1, 1, 1)));
+
+  // Light Sources
+  auto empty_material = shared_ptr<material>();
+  hittable_list lights(make_shared<quad>(point3(343, 554, 332), vec3(-130, 0, 0),
+                                         vec3(0, 0, -105), empty_material));
+
+  // BVH Acceleration
+  world = hittable_list(make_shared<bvh_node>(world, bvh_options));
+
+  // Camera
+  camera cam;
+
+  cam.aspect_ratio      = 1.0;
+  cam.image_width       = 600;
+  cam.samples_per_pixel = 200;
+  cam.max_depth         = 50;
+  cam.background_color  = color(0, 0, 0);
+
+  cam.vfov              = 40;
+  cam.lookfrom          = point3(278, 278, -800);
+  cam.lookat            = point3 (278, 278, 0);
+  cam.vup               = vec3(0, 1, 0);
+
+  cam.defocus_angle     = 0;
+
+  return {world, lights, cam};
+}
+
+inline scene final_scene(int image_width, int samples_per_pixel, int max_depth,
+                         const bvh_build_options& bvh_options = {}) {
+  // boxes1
+  hittable_list boxes1;
+  auto ground = make_shared<lambertian>(color(0.48, 0.83, 0.53));
+
+  int boxes_per_side = 20;
+  for (int i = 0; i < boxes_per_side; ++i) {
+    for (int j = 0; j < boxes_per_side; ++j) {
+      auto w  = 100.0;
+      auto x0 = -1000.0 + i*w;
+      auto z0 = -1000.0 + j*w;
+      auto y0 = 0.0;
+      auto x1 = x0 + w;
+      auto y1 = random_double(1, 101);
+      auto z1 = z0 + w;
+
+      boxes1.add(box(point3(x0, y0, z0), point3(x1, y1, z1), ground));
+    }
+  }
+
+  // World
+  hittable_list world;
+
+  // BVH acceleration for boxes1
+  world.add(make_shared<bvh_node>(boxes1, bvh_options));
+
+  // light
+  auto light = make_shared<diffuse_light>(color(7, 7, 7));
+  world.add(make_shared<quad>(point3(123, 554, 147), vec3(412, 0, 0),
+                              vec3(0, 0, 412), light));
+
+  // motion globe
+  auto center1 = point3(400, 400, 200);
+  auto center2 = center1 + vec3(30, 0, 0);
+  auto sphere_material = make_shared<lambertian>(color(0.7, 0.3, 0.1));
+  world.add(make_shared<sphere>(center1, center2, 50, sphere_material));
+
+  // glass
+  world.add(make_shared<sphere>(point3(260, 150, 45), 50,
+                                make_shared<dielectric>(1.5)));
+  // metal
+  world.add(make_shared<sphere>(point3(0, 150, 145), 50,
+                                make_shared<metal>(color(0.8, 0.8, 0.9), 1.0)));
+
+  // smoke volume
+  auto boundary = make_shared<sphere>(point3(360, 150, 145),
+                                      70,make_shared<dielectric>(1.5));
+  world.add(boundary);
+  world.add(make_shared<constant_medium>(boundary, 0.2, color(0.2, 0.4, 0.9)));
+  boundary = make_shared<sphere>(point3(0, 0, 0),
+                                 5000, make_shared<dielectric>(1.5));
+  world.add(make_shared<constant_medium>(boundary, .0001, color(1, 1, 1)));
+
+  // Earth
+  auto emat = make_shared<lambertian>(
+      make_shared<image_texture>("../assets/textures/earthmap.jpg"));
+  world.add(make_shared<sphere>(point3(400, 200, 400), 100, emat));
+
+  // Perlin noise
+  auto pertext = make_shared<noise_texture>(0.2);
+  world.add(make_shared<sphere>(point3(220, 280, 300), 80,
+                                make_shared<lambertian>(pertext)));
+
+  // boxes2
+  hittable_list boxes2;
+  auto white = make_shared<lambertian>(color(.73, .73, .73));
+  int ns = 1000;
+  for (int j = 0; j < ns; ++j) {
+    boxes2.add(make_shared<sphere>(point3::random(0, 165), 10, white));
+  }
+
+  // BVH acceleration, placed by one instance transform (translation after rotation)
+  world.add(make_shared<instance>(
+      make_shared<bvh_node>(boxes2, bvh_options),
+      affine_transform::translation(vec3(-100, 270, 395))
+          * affine_transform::rotation(vec3(0, 1, 0), 15)));
+
+  // Light Sources
+  auto empty_material = shared_ptr<material>();
+  hittable_list lights(make_shared<quad>(point3(123, 554, 147), vec3(412, 0, 0),
+                                         vec3(0, 0, 412), empty_material));
+
+  // Camera
+  camera cam;
+
+  cam.aspect_ratio      = 1.0;
+  cam.image_width       = image_width;
+  cam.samples_per_pixel = samples_per_pixel;
+  cam.max_depth         = max_depth;
+  cam.background_color  = color(0, 0, 0);
+
+  cam.vfov              = 40;
+  cam.lookfrom          = point3(478, 278, -600);
+  cam.lookat            = point3(278, 278, 0);
+  cam.vup               = vec3(0, 1, 0);
+
+  cam.defocus_angle     = 0;
+
+  return {world, lights, cam};
+}
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_SCENES_H_
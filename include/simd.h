@@ -0,0 +1,590 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: simd.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: The basic_lanes class holds N scalars that are processed together, one per
+ * lane, and basic_lane_mask holds the result of comparing them lane by lane. The instruction
+ * set is chosen at compile time: a lane type that fits a register of the target (SSE2 or
+ * SSE4.2, AVX2, AVX-512) is specialized with its intrinsics, every other one is split into two
+ * halves, down to native registers or to single scalar lanes. Define RTW_SIMD_SCALAR to
+ * force the scalar lanes everywhere.
+ * min and max follow the SSE convention (a < b ? a : b and a > b ? a : b), so that NaN
+ * operands behave the same in every implementation: the second operand is returned.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_SIMD_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_SIMD_H_
+
+#include <cmath>
+#include <cstdint>
+
+#ifndef RTW_SIMD_SCALAR
+#if defined(__AVX512F__)
+#define RTW_SIMD_AVX512 1
+#endif
+#if defined(__AVX2__)
+#define RTW_SIMD_AVX2 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#define RTW_SIMD_SSE 1
+#endif
+#endif
+
+#if defined(RTW_SIMD_AVX512) || defined(RTW_SIMD_AVX2) || defined(RTW_SIMD_SSE)
+#include <immintrin.h>
+#endif
+
+inline const char* simd_isa() {
+  // Name of the instruction set the lane types were compiled for.
+#if defined(RTW_SIMD_AVX512)
+  return "AVX-512";
+#elif defined(RTW_SIMD_AVX2)
+  return "AVX2";
+#elif defined(RTW_SIMD_SSE) && defined(__SSE4_2__)
+  return "SSE4.2";
+#elif defined(RTW_SIMD_SSE)
+  return "SSE2";
+#else
+  return "scalar";
+#endif
+}
+
+template <typename T, int N>
+class basic_lane_mask {
+  // The masks of the two halves of a lane type without a native register.
+ public:
+  using half_type = basic_lane_mask<T, N / 2>;
+
+  basic_lane_mask() = default;
+  basic_lane_mask(const half_type& lo, const half_type& hi) : lo(lo), hi(hi) {}
+
+  [[nodiscard]] unsigned bits() const { return lo.bits() | hi.bits() << (N / 2); }
+  [[nodiscard]] bool any() const { return lo.any() || hi.any(); }
+  [[nodiscard]] bool all() const { return lo.all() && hi.all(); }
+
+  friend basic_lane_mask operator&(const basic_lane_mask& a, const basic_lane_mask& b) { return {a.lo & b.lo, a.hi & b.hi}; }
+  friend basic_lane_mask operator|(const basic_lane_mask& a, const basic_lane_mask& b) { return {a.lo | b.lo, a.hi | b.hi}; }
+  friend basic_lane_mask operator~(const basic_lane_mask& a) { return {~a.lo, ~a.hi}; }
+
+  half_type lo, hi;
+};
+
+template <typename T, int N>
+class basic_lanes {
+  // A lane type without a native register is split into two halves, down to native
+  // registers or, in the scalar fallback, to single lanes.
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "lane counts must be powers of two");
+
+ public:
+  using scalar_type = T;
+  using mask_type = basic_lane_mask<T, N>;
+  using half_type = basic_lanes<T, N / 2>;
+  static constexpr int width = N;
+
+  basic_lanes() = default;
+  basic_lanes(T s) : lo(s), hi(s) {}  // NOLINT: scalars broadcast implicitly, as in 2 * x
+  basic_lanes(const half_type& lo, const half_type& hi) : lo(lo), hi(hi) {}
+
+  static basic_lanes load(const T* p) { return {half_type::load(p), half_type::load(p + N / 2)}; }
+
+  void store(T* p) const {
+    lo.store(p);
+    hi.store(p + N / 2);
+  }
+
+  [[nodiscard]] T lane(int i) const { return i < N / 2 ? lo.lane(i) : hi.lane(i - N / 2); }
+
+  friend basic_lanes operator+(const basic_lanes& a, const basic_lanes& b) { return {a.lo + b.lo, a.hi + b.hi}; }
+  friend basic_lanes operator-(const basic_lanes& a, const basic_lanes& b) { return {a.lo - b.lo, a.hi - b.hi}; }
+  friend basic_lanes operator*(const basic_lanes& a, const basic_lanes& b) { return {a.lo * b.lo, a.hi * b.hi}; }
+  friend basic_lanes operator/(const basic_lanes& a, const basic_lanes& b) { return {a.lo / b.lo, a.hi / b.hi}; }
+  friend basic_lanes min(const basic_lanes& a, const basic_lanes& b) { return {min(a.lo, b.lo), min(a.hi, b.hi)}; }
+  friend basic_lanes max(const basic_lanes& a, const basic_lanes& b) { return {max(a.lo, b.lo), max(a.hi, b.hi)}; }
+
+  friend basic_lanes operator-(const basic_lanes& a) { return {-a.lo, -a.hi}; }
+  friend basic_lanes sqrt(const basic_lanes& a) { return {sqrt(a.lo), sqrt(a.hi)}; }
+  friend basic_lanes abs(const basic_lanes& a) { return {abs(a.lo), abs(a.hi)}; }
+
+  friend mask_type operator<(const basic_lanes& a, const basic_lanes& b) { return {a.lo < b.lo, a.hi < b.hi}; }
+  friend mask_type operator<=(const basic_lanes& a, const basic_lanes& b) { return {a.lo <= b.lo, a.hi <= b.hi}; }
+  friend mask_type operator>(const basic_lanes& a, const basic_lanes& b) { return {a.lo > b.lo, a.hi > b.hi}; }
+  friend mask_type operator>=(const basic_lanes& a, const basic_lanes& b) { return {a.lo >= b.lo, a.hi >= b.hi}; }
+  friend mask_type operator==(const basic_lanes& a, const basic_lanes& b) { return {a.lo == b.lo, a.hi == b.hi}; }
+
+  friend basic_lanes select(const mask_type& m, const basic_lanes& a, const basic_lanes& b) {
+    // a in the lanes of the mask, b in the others.
+    return {select(m.lo, a.lo, b.lo), select(m.hi, a.hi, b.hi)};
+  }
+
+  half_type lo, hi;
+};
+
+template <typename T>
+class basic_lane_mask<T, 1> {
+  // The flag of a single lane.
+ public:
+  basic_lane_mask() = default;
+  explicit basic_lane_mask(bool m) : m(m) {}
+
+  [[nodiscard]] unsigned bits() const { return m; }
+  [[nodiscard]] bool any() const { return m; }
+  [[nodiscard]] bool all() const { return m; }
+
+  friend basic_lane_mask operator&(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(a.m && b.m); }
+  friend basic_lane_mask operator|(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(a.m || b.m); }
+  friend basic_lane_mask operator~(basic_lane_mask a) { return basic_lane_mask(!a.m); }
+
+ private:
+  bool m = false;
+};
+
+template <typename T>
+class basic_lanes<T, 1> {
+  // A single lane: the scalar fallback.
+ public:
+  using scalar_type = T;
+  using mask_type = basic_lane_mask<T, 1>;
+  static constexpr int width = 1;
+
+  basic_lanes() = default;
+  basic_lanes(T s) : v(s) {}  // NOLINT
+
+  static basic_lanes load(const T* p) { return *p; }
+  void store(T* p) const { *p = v; }
+
+  [[nodiscard]] T lane(int) const { return v; }
+
+  friend basic_lanes operator+(basic_lanes a, basic_lanes b) { return a.v + b.v; }
+  friend basic_lanes operator-(basic_lanes a, basic_lanes b) { return a.v - b.v; }
+  friend basic_lanes operator*(basic_lanes a, basic_lanes b) { return a.v * b.v; }
+  friend basic_lanes operator/(basic_lanes a, basic_lanes b) { return a.v / b.v; }
+  friend basic_lanes min(basic_lanes a, basic_lanes b) { return a.v < b.v ? a.v : b.v; }
+  friend basic_lanes max(basic_lanes a, basic_lanes b) { return a.v > b.v ? a.v : b.v; }
+
+  friend basic_lanes operator-(basic_lanes a) { return -a.v; }
+  friend basic_lanes sqrt(basic_lanes a) { return std::sqrt(a.v); }
+  friend basic_lanes abs(basic_lanes a) { return std::fabs(a.v); }
+
+  friend mask_type operator<(basic_lanes a, basic_lanes b) { return mask_type(a.v < b.v); }
+  friend mask_type operator<=(basic_lanes a, basic_lanes b) { return mask_type(a.v <= b.v); }
+  friend mask_type operator>(basic_lanes a, basic_lanes b) { return mask_type(a.v > b.v); }
+  friend mask_type operator>=(basic_lanes a, basic_lanes b) { return mask_type(a.v >= b.v); }
+  friend mask_type operator==(basic_lanes a, basic_lanes b) { return mask_type(a.v == b.v); }
+
+  friend basic_lanes select(mask_type m, basic_lanes a, basic_lanes b) { return m.any() ? a : b; }
+
+ private:
+  T v{};
+};
+
+// Compound assignment and reductions for every lane type.
+
+template <typename T, int N>
+inline basic_lanes<T, N>& operator+=(basic_lanes<T, N>& a, const basic_lanes<T, N>& b) { return a = a + b; }
+template <typename T, int N>
+inline basic_lanes<T, N>& operator-=(basic_lanes<T, N>& a, const basic_lanes<T, N>& b) { return a = a - b; }
+template <typename T, int N>
+inline basic_lanes<T, N>& operator*=(basic_lanes<T, N>& a, const basic_lanes<T, N>& b) { return a = a * b; }
+
+template <typename T, int N>
+inline T reduce_add(const basic_lanes<T, N>& a) {
+  // Sum of all lanes, added in lane order.
+  T sum = a.lane(0);
+  for (int i = 1; i < N; ++i) sum += a.lane(i);
+  return sum;
+}
+
+template <typename T>
+inline basic_lanes<T, 4> yzxw(const basic_lanes<T, 4>& a) {
+  // Rotates the first three lanes: (x, y, z, w) -> (y, z, x, w).
+  T r[4] = {a.lane(1), a.lane(2), a.lane(0), a.lane(3)};
+  return basic_lanes<T, 4>::load(r);
+}
+
+#ifdef RTW_SIMD_SSE
+
+// Blends a and b by a comparison mask: blendv with SSE4.1, and/andnot/or without it.
+inline __m128 blend_lanes(__m128 m, __m128 a, __m128 b) {
+#ifdef __SSE4_1__
+  return _mm_blendv_ps(b, a, m);
+#else
+  return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+#endif
+}
+
+inline __m128d blend_lanes(__m128d m, __m128d a, __m128d b) {
+#ifdef __SSE4_1__
+  return _mm_blendv_pd(b, a, m);
+#else
+  return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b));
+#endif
+}
+
+template <>
+class basic_lane_mask<float, 4> {
+ public:
+  basic_lane_mask() : m(_mm_setzero_ps()) {}
+  explicit basic_lane_mask(__m128 m) : m(m) {}
+
+  [[nodiscard]] unsigned bits() const { return static_cast<unsigned>(_mm_movemask_ps(m)); }
+  [[nodiscard]] bool any() const { return bits() != 0; }
+  [[nodiscard]] bool all() const { return bits() == 0xF; }
+  [[nodiscard]] __m128 native() const { return m; }
+
+  friend basic_lane_mask operator&(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(_mm_and_ps(a.m, b.m)); }
+  friend basic_lane_mask operator|(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(_mm_or_ps(a.m, b.m)); }
+  friend basic_lane_mask operator~(basic_lane_mask a) {
+    return basic_lane_mask(_mm_xor_ps(a.m, _mm_castsi128_ps(_mm_set1_epi32(-1))));
+  }
+
+ private:
+  __m128 m;
+};
+
+template <>
+class basic_lanes<float, 4> {
+ public:
+  using scalar_type = float;
+  using mask_type = basic_lane_mask<float, 4>;
+  static constexpr int width = 4;
+
+  basic_lanes() : v(_mm_setzero_ps()) {}
+  basic_lanes(float s) : v(_mm_set1_ps(s)) {}  // NOLINT
+  explicit basic_lanes(__m128 v) : v(v) {}
+
+  static basic_lanes load(const float* p) { return basic_lanes(_mm_loadu_ps(p)); }
+  void store(float* p) const { _mm_storeu_ps(p, v); }
+
+  [[nodiscard]] float lane(int i) const {
+    alignas(16) float t[4];
+    _mm_store_ps(t, v);
+    return t[i];
+  }
+
+  friend basic_lanes operator+(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_add_ps(a.v, b.v)); }
+  friend basic_lanes operator-(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_sub_ps(a.v, b.v)); }
+  friend basic_lanes operator*(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_mul_ps(a.v, b.v)); }
+  friend basic_lanes operator/(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_div_ps(a.v, b.v)); }
+  friend basic_lanes min(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_min_ps(a.v, b.v)); }
+  friend basic_lanes max(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_max_ps(a.v, b.v)); }
+
+  friend basic_lanes operator-(basic_lanes a) { return basic_lanes(_mm_xor_ps(a.v, _mm_set1_ps(-0.0f))); }
+  friend basic_lanes sqrt(basic_lanes a) { return basic_lanes(_mm_sqrt_ps(a.v)); }
+  friend basic_lanes abs(basic_lanes a) { return basic_lanes(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)); }
+
+  friend mask_type operator<(basic_lanes a, basic_lanes b) { return mask_type(_mm_cmplt_ps(a.v, b.v)); }
+  friend mask_type operator<=(basic_lanes a, basic_lanes b) { return mask_type(_mm_cmple_ps(a.v, b.v)); }
+  friend mask_type operator>(basic_lanes a, basic_lanes b) { return mask_type(_mm_cmpgt_ps(a.v, b.v)); }
+  friend mask_type operator>=(basic_lanes a, basic_lanes b) { return mask_type(_mm_cmpge_ps(a.v, b.v)); }
+  friend mask_type operator==(basic_lanes a, basic_lanes b) { return mask_type(_mm_cmpeq_ps(a.v, b.v)); }
+
+  friend basic_lanes select(mask_type m, basic_lanes a, basic_lanes b) {
+    return basic_lanes(blend_lanes(m.native(), a.v, b.v));
+  }
+
+  [[nodiscard]] __m128 native() const { return v; }
+
+ private:
+  __m128 v;
+};
+
+template <>
+class basic_lane_mask<double, 2> {
+ public:
+  basic_lane_mask() : m(_mm_setzero_pd()) {}
+  explicit basic_lane_mask(__m128d m) : m(m) {}
+
+  [[nodiscard]] unsigned bits() const { return static_cast<unsigned>(_mm_movemask_pd(m)); }
+  [[nodiscard]] bool any() const { return bits() != 0; }
+  [[nodiscard]] bool all() const { return bits() == 0x3; }
+  [[nodiscard]] __m128d native() const { return m; }
+
+  friend basic_lane_mask operator&(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(_mm_and_pd(a.m, b.m)); }
+  friend basic_lane_mask operator|(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(_mm_or_pd(a.m, b.m)); }
+  friend basic_lane_mask operator~(basic_lane_mask a) {
+    return basic_lane_mask(_mm_xor_pd(a.m, _mm_castsi128_pd(_mm_set1_epi32(-1))));
+  }
+
+ private:
+  __m128d m;
+};
+
+template <>
+class basic_lanes<double, 2> {
+ public:
+  using scalar_type = double;
+  using mask_type = basic_lane_mask<double, 2>;
+  static constexpr int width = 2;
+
+  basic_lanes() : v(_mm_setzero_pd()) {}
+  basic_lanes(double s) : v(_mm_set1_pd(s)) {}  // NOLINT
+  explicit basic_lanes(__m128d v) : v(v) {}
+
+  static basic_lanes load(const double* p) { return basic_lanes(_mm_loadu_pd(p)); }
+  void store(double* p) const { _mm_storeu_pd(p, v); }
+
+  [[nodiscard]] double lane(int i) const {
+    alignas(16) double t[2];
+    _mm_store_pd(t, v);
+    return t[i];
+  }
+
+  friend basic_lanes operator+(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_add_pd(a.v, b.v)); }
+  friend basic_lanes operator-(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_sub_pd(a.v, b.v)); }
+  friend basic_lanes operator*(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_mul_pd(a.v, b.v)); }
+  friend basic_lanes operator/(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_div_pd(a.v, b.v)); }
+  friend basic_lanes min(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_min_pd(a.v, b.v)); }
+  friend basic_lanes max(basic_lanes a, basic_lanes b) { return basic_lanes(_mm_max_pd(a.v, b.v)); }
+
+  friend basic_lanes operator-(basic_lanes a) { return basic_lanes(_mm_xor_pd(a.v, _mm_set1_pd(-0.0))); }
+  friend basic_lanes sqrt(basic_lanes a) { return basic_lanes(_mm_sqrt_pd(a.v)); }
+  friend basic_lanes abs(basic_lanes a) { return basic_lanes(_mm_andnot_pd(_mm_set1_pd(-0.0), a.v)); }
+
+  friend mask_type operator<(basic_lanes a, basic_lanes b) { return mask_type(_mm_cmplt_pd(a.v, b.v)); }
+  friend mask_type operator<=(basic_lanes a, basic_lanes b) { return mask_type(_mm_cmple_pd(a.v, b.v)); }
+  friend mask_type operator>(basic_lanes a, basic_lanes b) { return mask_type(_mm_cmpgt_pd(a.v, b.v)); }
+  friend mask_type operator>=(basic_lanes a, basic_lanes b) { return mask_type(_mm_cmpge_pd(a.v, b.v)); }
+  friend mask_type operator==(basic_lanes a, basic_lanes b) { return mask_type(_mm_cmpeq_pd(a.v, b.v)); }
+
+  friend basic_lanes select(mask_type m, basic_lanes a, basic_lanes b) {
+    return basic_lanes(blend_lanes(m.native(), a.v, b.v));
+  }
+
+  [[nodiscard]] __m128d native() const { return v; }
+
+ private:
+  __m128d v;
+};
+
+inline basic_lanes<float, 4> yzxw(const basic_lanes<float, 4>& a) {
+  return basic_lanes<float, 4>(_mm_shuffle_ps(a.native(), a.native(), _MM_SHUFFLE(3, 0, 2, 1)));
+}
+
+#endif  // RTW_SIMD_SSE
+
+#ifdef RTW_SIMD_AVX2
+
+template <>
+class basic_lane_mask<float, 8> {
+ public:
+  basic_lane_mask() : m(_mm256_setzero_ps()) {}
+  explicit basic_lane_mask(__m256 m) : m(m) {}
+
+  [[nodiscard]] unsigned bits() const { return static_cast<unsigned>(_mm256_movemask_ps(m)); }
+  [[nodiscard]] bool any() const { return !_mm256_testz_ps(m, m); }
+  [[nodiscard]] bool all() const { return bits() == 0xFF; }
+  [[nodiscard]] __m256 native() const { return m; }
+
+  friend basic_lane_mask operator&(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(_mm256_and_ps(a.m, b.m)); }
+  friend basic_lane_mask operator|(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(_mm256_or_ps(a.m, b.m)); }
+  friend basic_lane_mask operator~(basic_lane_mask a) {
+    return basic_lane_mask(_mm256_xor_ps(a.m, _mm256_castsi256_ps(_mm256_set1_epi32(-1))));
+  }
+
+ private:
+  __m256 m;
+};
+
+template <>
+class basic_lanes<float, 8> {
+ public:
+  using scalar_type = float;
+  using mask_type = basic_lane_mask<float, 8>;
+  static constexpr int width = 8;
+
+  basic_lanes() : v(_mm256_setzero_ps()) {}
+  basic_lanes(float s) : v(_mm256_set1_ps(s)) {}  // NOLINT
+  explicit basic_lanes(__m256 v) : v(v) {}
+
+  static basic_lanes load(const float* p) { return basic_lanes(_mm256_loadu_ps(p)); }
+  void store(float* p) const { _mm256_storeu_ps(p, v); }
+
+  [[nodiscard]] float lane(int i) const {
+    alignas(32) float t[8];
+    _mm256_store_ps(t, v);
+    return t[i];
+  }
+
+  friend basic_lanes operator+(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_add_ps(a.v, b.v)); }
+  friend basic_lanes operator-(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_sub_ps(a.v, b.v)); }
+  friend basic_lanes operator*(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_mul_ps(a.v, b.v)); }
+  friend basic_lanes operator/(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_div_ps(a.v, b.v)); }
+  friend basic_lanes min(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_min_ps(a.v, b.v)); }
+  friend basic_lanes max(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_max_ps(a.v, b.v)); }
+
+  friend basic_lanes operator-(basic_lanes a) { return basic_lanes(_mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f))); }
+  friend basic_lanes sqrt(basic_lanes a) { return basic_lanes(_mm256_sqrt_ps(a.v)); }
+  friend basic_lanes abs(basic_lanes a) { return basic_lanes(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)); }
+
+  friend mask_type operator<(basic_lanes a, basic_lanes b) { return mask_type(_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)); }
+  friend mask_type operator<=(basic_lanes a, basic_lanes b) { return mask_type(_mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ)); }
+  friend mask_type operator>(basic_lanes a, basic_lanes b) { return mask_type(_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)); }
+  friend mask_type operator>=(basic_lanes a, basic_lanes b) { return mask_type(_mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ)); }
+  friend mask_type operator==(basic_lanes a, basic_lanes b) { return mask_type(_mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ)); }
+
+  friend basic_lanes select(mask_type m, basic_lanes a, basic_lanes b) {
+    return basic_lanes(_mm256_blendv_ps(b.v, a.v, m.native()));
+  }
+
+  [[nodiscard]] __m256 native() const { return v; }
+
+ private:
+  __m256 v;
+};
+
+template <>
+class basic_lane_mask<double, 4> {
+ public:
+  basic_lane_mask() : m(_mm256_setzero_pd()) {}
+  explicit basic_lane_mask(__m256d m) : m(m) {}
+
+  [[nodiscard]] unsigned bits() const { return static_cast<unsigned>(_mm256_movemask_pd(m)); }
+  [[nodiscard]] bool any() const { return !_mm256_testz_pd(m, m); }
+  [[nodiscard]] bool all() const { return bits() == 0xF; }
+  [[nodiscard]] __m256d native() const { return m; }
+
+  friend basic_lane_mask operator&(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(_mm256_and_pd(a.m, b.m)); }
+  friend basic_lane_mask operator|(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(_mm256_or_pd(a.m, b.m)); }
+  friend basic_lane_mask operator~(basic_lane_mask a) {
+    return basic_lane_mask(_mm256_xor_pd(a.m, _mm256_castsi256_pd(_mm256_set1_epi64x(-1))));
+  }
+
+ private:
+  __m256d m;
+};
+
+template <>
+class basic_lanes<double, 4> {
+ public:
+  using scalar_type = double;
+  using mask_type = basic_lane_mask<double, 4>;
+  static constexpr int width = 4;
+
+  basic_lanes() : v(_mm256_setzero_pd()) {}
+  basic_lanes(double s) : v(_mm256_set1_pd(s)) {}  // NOLINT
+  explicit basic_lanes(__m256d v) : v(v) {}
+
+  static basic_lanes load(const double* p) { return basic_lanes(_mm256_loadu_pd(p)); }
+  void store(double* p) const { _mm256_storeu_pd(p, v); }
+
+  [[nodiscard]] double lane(int i) const {
+    alignas(32) double t[4];
+    _mm256_store_pd(t, v);
+    return t[i];
+  }
+
+  friend basic_lanes operator+(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_add_pd(a.v, b.v)); }
+  friend basic_lanes operator-(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_sub_pd(a.v, b.v)); }
+  friend basic_lanes operator*(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_mul_pd(a.v, b.v)); }
+  friend basic_lanes operator/(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_div_pd(a.v, b.v)); }
+  friend basic_lanes min(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_min_pd(a.v, b.v)); }
+  friend basic_lanes max(basic_lanes a, basic_lanes b) { return basic_lanes(_mm256_max_pd(a.v, b.v)); }
+
+  friend basic_lanes operator-(basic_lanes a) { return basic_lanes(_mm256_xor_pd(a.v, _mm256_set1_pd(-0.0))); }
+  friend basic_lanes sqrt(basic_lanes a) { return basic_lanes(_mm256_sqrt_pd(a.v)); }
+  friend basic_lanes abs(basic_lanes a) { return basic_lanes(_mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v)); }
+
+  friend mask_type operator<(basic_lanes a, basic_lanes b) { return mask_type(_mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ)); }
+  friend mask_type operator<=(basic_lanes a, basic_lanes b) { return mask_type(_mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ)); }
+  friend mask_type operator>(basic_lanes a, basic_lanes b) { return mask_type(_mm256_cmp_pd(a.v, b.v, _CMP_GT_OQ)); }
+  friend mask_type operator>=(basic_lanes a, basic_lanes b) { return mask_type(_mm256_cmp_pd(a.v, b.v, _CMP_GE_OQ)); }
+  friend mask_type operator==(basic_lanes a, basic_lanes b) { return mask_type(_mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ)); }
+
+  friend basic_lanes select(mask_type m, basic_lanes a, basic_lanes b) {
+    return basic_lanes(_mm256_blendv_pd(b.v, a.v, m.native()));
+  }
+
+  [[nodiscard]] __m256d native() const { return v; }
+
+ private:
+  __m256d v;
+};
+
+inline basic_lanes<double, 4> yzxw(const basic_lanes<double, 4>& a) {
+  return basic_lanes<double, 4>(_mm256_permute4x64_pd(a.native(), _MM_SHUFFLE(3, 0, 2, 1)));
+}
+
+#endif  // RTW_SIMD_AVX2
+
+#ifdef RTW_SIMD_AVX512
+
+template <>
+class basic_lane_mask<double, 8> {
+ public:
+  basic_lane_mask() = default;
+  explicit basic_lane_mask(__mmask8 m) : m(m) {}
+
+  [[nodiscard]] unsigned bits() const { return m; }
+  [[nodiscard]] bool any() const { return m != 0; }
+  [[nodiscard]] bool all() const { return m == 0xFF; }
+  [[nodiscard]] __mmask8 native() const { return m; }
+
+  friend basic_lane_mask operator&(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(a.m & b.m); }
+  friend basic_lane_mask operator|(basic_lane_mask a, basic_lane_mask b) { return basic_lane_mask(a.m | b.m); }
+  friend basic_lane_mask operator~(basic_lane_mask a) { return basic_lane_mask(static_cast<__mmask8>(~a.m)); }
+
+ private:
+  __mmask8 m = 0;
+};
+
+template <>
+class basic_lanes<double, 8> {
+ public:
+  using scalar_type = double;
+  using mask_type = basic_lane_mask<double, 8>;
+  static constexpr int width = 8;
+
+  basic_lanes() : v(_mm512_setzero_pd()) {}
+  basic_lanes(double s) : v(_mm512_set1_pd(s)) {}  // NOLINT
+  explicit basic_lanes(__m512d v) : v(v) {}
+
+  static basic_lanes load(const double* p) { return basic_lanes(_mm512_loadu_pd(p)); }
+  void store(double* p) const { _mm512_storeu_pd(p, v); }
+
+  [[nodiscard]] double lane(int i) const {
+    alignas(64) double t[8];
+    _mm512_store_pd(t, v);
+    return t[i];
+  }
+
+  friend basic_lanes operator+(basic_lanes a, basic_lanes b) { return basic_lanes(_mm512_add_pd(a.v, b.v)); }
+  friend basic_lanes operator-(basic_lanes a, basic_lanes b) { return basic_lanes(_mm512_sub_pd(a.v, b.v)); }
+  friend basic_lanes operator*(basic_lanes a, basic_lanes b) { return basic_lanes(_mm512_mul_pd(a.v, b.v)); }
+  friend basic_lanes operator/(basic_lanes a, basic_lanes b) { return basic_lanes(_mm512_div_pd(a.v, b.v)); }
+  friend basic_lanes min(basic_lanes a, basic_lanes b) { return basic_lanes(_mm512_min_pd(a.v, b.v)); }
+  friend basic_lanes max(basic_lanes a, basic_lanes b) { return basic_lanes(_mm512_max_pd(a.v, b.v)); }
+
+  friend basic_lanes operator-(basic_lanes a) {
+    return basic_lanes(_mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a.v),
+                                                            _mm512_set1_epi64(INT64_MIN))));
+  }
+  friend basic_lanes sqrt(basic_lanes a) { return basic_lanes(_mm512_sqrt_pd(a.v)); }
+  friend basic_lanes abs(basic_lanes a) {
+    return basic_lanes(_mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a.v),
+                                                            _mm512_set1_epi64(INT64_MAX))));
+  }
+
+  friend mask_type operator<(basic_lanes a, basic_lanes b) { return mask_type(_mm512_cmp_pd_mask(a.v, b.v, _CMP_LT_OQ)); }
+  friend mask_type operator<=(basic_lanes a, basic_lanes b) { return mask_type(_mm512_cmp_pd_mask(a.v, b.v, _CMP_LE_OQ)); }
+  friend mask_type operator>(basic_lanes a, basic_lanes b) { return mask_type(_mm512_cmp_pd_mask(a.v, b.v, _CMP_GT_OQ)); }
+  friend mask_type operator>=(basic_lanes a, basic_lanes b) { return mask_type(_mm512_cmp_pd_mask(a.v, b.v, _CMP_GE_OQ)); }
+  friend mask_type operator==(basic_lanes a, basic_lanes b) { return mask_type(_mm512_cmp_pd_mask(a.v, b.v, _CMP_EQ_OQ)); }
+
+  friend basic_lanes select(mask_type m, basic_lanes a, basic_lanes b) {
+    return basic_lanes(_mm512_mask_blend_pd(m.native(), b.v, a.v));
+  }
+
+  [[nodiscard]] __m512d native() const { return v; }
+
+ private:
+  __m512d v;
+};
+
+#endif  // RTW_SIMD_AVX512
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_SIMD_H_
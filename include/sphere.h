@@ -17,25 +17,26 @@
 #include "rtweekend.h"
 
 #include "hittable.h"
+#include "material.h"
 
 
 class sphere : public hittable {
 public:
     // Constructors
     // Stationary Sphere
-    sphere(const point3& static_center, double radius, shared_ptr<material> mat)
+    sphere(const point3& static_center, real radius, shared_ptr<material> mat)
         : center(static_center, vec3(0,0,0)),
-        radius(std::fmax(0, radius)), mat(std::move(mat))
+        radius(std::fmax(0, radius)), mat(std::move(mat)), mat_id(this->mat ? this->mat->id() : -1)
     {
         auto rvec = vec3(radius, radius, radius);
         bbox = AABB(static_center - rvec, static_center + rvec);
     };
 
     // Moving Sphere
-    sphere(const point3& center1, const point3& center2, double radius,
+    sphere(const point3& center1, const point3& center2, real radius,
            shared_ptr<material> mat)
         : center(center1, center2 - center1),
-        radius(std::fmax(0, radius)), mat(std::move(mat))
+        radius(std::fmax(0, radius)), mat(std::move(mat)), mat_id(this->mat ? this->mat->id() : -1)
     {
         auto rvec = vec3(radius, radius, radius);
         AABB box1(center.at(0) - rvec, center.at(0) + rvec);
@@ -69,24 +70,64 @@ public:
                 return false;
         }
 
-        // Record the hit information.
-        rec.t = root;
-        rec.p = r.at(rec.t);
-        vec3 outward_normal = (rec.p - current_center) / radius;
-        rec.set_face_normal(r, outward_normal);
-        get_sphere_uv(outward_normal, rec.u, rec.v);
-        rec.mat = mat;
-
+        record_hit(r, root, current_center, rec);
         return true;
     }
 
+    // The same test as hit, for all lanes of a packet at once.
+    lane_mask hit_packet(ray_packet& packet, lane_mask mask, hit_record* recs) const override {
+        const point3& c0 = center.origin();
+        const vec3& c1 = center.direction();
+        real roots[packet_width];
+        bool found[packet_width];
+
+        for (int lane = 0; lane < packet_width; ++lane) {
+            auto t = packet.time[lane];
+            auto cx = c0.x() + t*c1.x(), cy = c0.y() + t*c1.y(), cz = c0.z() + t*c1.z();
+            auto ocx = cx - packet.ox[lane], ocy = cy - packet.oy[lane], ocz = cz - packet.oz[lane];
+            auto dx = packet.dx[lane], dy = packet.dy[lane], dz = packet.dz[lane];
+
+            auto a = dx*dx + dy*dy + dz*dz;
+            auto h = ocx*dx + ocy*dy + ocz*dz;
+            auto c = (ocx*ocx + ocy*ocy + ocz*ocz) - radius * radius;
+            auto discriminant = h * h - a * c;
+            auto sqrtd = std::sqrt(discriminant < 0 ? 0.0 : discriminant);
+
+            auto near_root = (h - sqrtd) / a;
+            auto far_root = (h + sqrtd) / a;
+            bool near_ok = packet.t_min < near_root && near_root < packet.t_max[lane];
+            bool far_ok = packet.t_min < far_root && far_root < packet.t_max[lane];
+
+            roots[lane] = near_ok ? near_root : far_root;
+            found[lane] = discriminant >= 0 && (near_ok || far_ok);
+        }
+
+        lane_mask hits = 0;
+        for (int lane = 0; lane < packet_width; ++lane) {
+            if (!(mask & (1u << lane)) || !found[lane])
+                continue;
+
+            const ray& r = packet.rays[lane];
+            record_hit(r, roots[lane], center.at(r.time()), recs[lane]);
+            packet.t_max[lane] = roots[lane];
+            hits |= 1u << lane;
+        }
+        return hits;
+    }
+
     [[nodiscard]] AABB bounding_box() const override {
         return bbox;
     }
 
+    [[nodiscard]] motion_box motion_bounding_box() const override {
+        // The center moves linearly, so the interpolated box is the sphere's box at any time.
+        auto rvec = vec3(radius, radius, radius);
+        return {AABB(center.at(0) - rvec, center.at(0) + rvec), AABB(center.at(1) - rvec, center.at(1) + rvec)};
+    }
+
     // Calculate the probability density function (PDF) value for a given ray direction
     // relative to a point in space.
-    [[nodiscard]] double pdf_value(const point3& origin, const vec3& direction) const override {
+    [[nodiscard]] real pdf_value(const point3& origin, const vec3& direction) const override {
         // Create a temporary hit record and check if the ray hits the sphere
         hit_record rec;
         if (!this->hit(ray(origin, direction), interval(0.001, infinity), rec))
@@ -119,11 +160,22 @@ public:
 private:
     // Data
     ray center;
-    double radius;
+    real radius;
     shared_ptr<material> mat;
+    int mat_id; // The index of mat in the material table
     AABB bbox;
 
-    static void get_sphere_uv(const point3& p, double& u, double& v) {
+    void record_hit(const ray& r, real root, const point3& current_center, hit_record& rec) const {
+        // Record the hit information.
+        rec.t = root;
+        rec.p = r.at(rec.t);
+        vec3 outward_normal = (rec.p - current_center) / radius;
+        rec.set_face_normal(r, outward_normal);
+        get_sphere_uv(outward_normal, rec.u, rec.v);
+        rec.mat_id = mat_id;
+    }
+
+    static void get_sphere_uv(const point3& p, real& u, real& v) {
         // Get the spherical coordinates of a point on the unit sphere.
         // p: a given point on the sphere of radius one, centered at the origin.
         // u: returned value [0,1] of angle around the Y axis from X=-1.
@@ -142,7 +194,7 @@ private:
     // Helper function to generate a random direction vector towards a sphere
     // radius: The radius of the sphere
     // distance_squared: The squared distance from the sampling point to sphere center
-    static vec3 random_to_sphere(double radius, double distance_squared) {
+    static vec3 random_to_sphere(real radius, real distance_squared) {
         // Generate two random numbers between 0 and 1
         auto r1 = random_double();
         auto r2 = random_double();
@@ -160,7 +212,7 @@ private:
         auto y = std::sin(phi) * std::sqrt(1 - z*z);
 
         // Return the normalized direction vector
-        return {x, y, z};
+        return vec3(x, y, z);
     }
 };
 #endif //RAYTRACINGINONEWEEKEND_SPHERE_H
@@ -0,0 +1,85 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: stats.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: Counters of the work done by BVH traversal: boxes and primitives
+ * tested. Every thread counts into its own counters, which are added to the global totals
+ * when the thread exits, so the hot loops never share a cache line. The counters are only
+ * compiled in when RTW_TRAVERSAL_STATS is defined; otherwise RTW_COUNT and RTW_ADD expand
+ * to nothing.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_STATS_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_STATS_H_
+
+#include <mutex>
+
+struct traversal_counts {
+  long long box_tests       = 0;  // Node boxes tested, one per box also in wide nodes
+  long long primitive_tests = 0;  // Primitives tested in BVH leaves
+
+  traversal_counts& operator+=(const traversal_counts& other) {
+    box_tests += other.box_tests;
+    primitive_tests += other.primitive_tests;
+    return *this;
+  }
+};
+
+class traversal_stats {
+ public:
+  static traversal_counts& local() {
+    // The counters of the calling thread.
+    thread_local thread_counters counters;
+    return counters.counts;
+  }
+
+  static traversal_counts collect() {
+    // Totals of the threads that have exited plus the calling thread's own counters.
+    std::lock_guard<std::mutex> lock(totals().mutex);
+    auto counts = totals().counts;
+    counts += local();
+    return counts;
+  }
+
+  static void reset() {
+    // Restart counting; call while no other thread is tracing.
+    std::lock_guard<std::mutex> lock(totals().mutex);
+    totals().counts = {};
+    local() = {};
+  }
+
+ private:
+  struct shared_totals {
+    std::mutex       mutex;
+    traversal_counts counts;
+  };
+
+  struct thread_counters {
+    traversal_counts counts;
+
+    ~thread_counters() {
+      std::lock_guard<std::mutex> lock(totals().mutex);
+      totals().counts += counts;
+    }
+  };
+
+  static shared_totals& totals() {
+    static shared_totals instance;
+    return instance;
+  }
+};
+
+#ifdef RTW_TRAVERSAL_STATS
+#define RTW_COUNT(counter) (++traversal_stats::local().counter)
+#define RTW_ADD(counter, n) (traversal_stats::local().counter += (n))
+#else
+#define RTW_COUNT(counter) ((void)0)
+#define RTW_ADD(counter, n) ((void)0)
+#endif
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_STATS_H_
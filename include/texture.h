@@ -25,7 +25,7 @@ public:
     virtual  ~texture() = default;
 
     // Return the color of the texture at the given UV coordinates.
-    virtual color value(double u, double v, const point3& p) const = 0;
+    virtual color value(real u, real v, const point3& p) const = 0;
 };
 
 class solid_color : public texture {
@@ -33,10 +33,10 @@ class solid_color : public texture {
 public:
         explicit solid_color(const color& albedo) : albedo(albedo) {}
 
-        solid_color(double red, double green, double blue)
+        solid_color(real red, real green, real blue)
             : solid_color(color(red, green, blue)) {}
 
-        color value(double u, double v, const point3& p) const override {
+        color value(real u, real v, const point3& p) const override {
             return albedo;
         }
 
@@ -47,14 +47,14 @@ private:
 class checker_texture : public texture {
     // The checker_texture class represents a checkerboard texture.
 public:
-    checker_texture(double scale, shared_ptr<texture> even, shared_ptr<texture> odd)
+    checker_texture(real scale, shared_ptr<texture> even, shared_ptr<texture> odd)
       : inv_scale(1.0/scale), even(std::move(even)), odd(std::move(odd)) {}
 
-    checker_texture(double scale, color c1, color c2)
+    checker_texture(real scale, color c1, color c2)
       : checker_texture(scale, make_shared<solid_color>(c1),
           make_shared<solid_color>(c2)) {}
 
-    color value(double u, double v, const point3& p) const override {
+    color value(real u, real v, const point3& p) const override {
         auto xInteger = int(std::floor(inv_scale * p.x()));
         auto yInteger = int(std::floor(inv_scale * p.y()));
         auto zInteger = int(std::floor(inv_scale * p.z()));
@@ -65,7 +65,7 @@ public:
       }
 
 private:
-    double              inv_scale;  // To control the size of the checkerboard.
+    real                inv_scale;  // To control the size of the checkerboard.
     shared_ptr<texture> even;       // The even texture.
     shared_ptr<texture> odd;        // The odd texture.
 
@@ -76,7 +76,7 @@ class image_texture : public texture {
 public:
   explicit image_texture(const char* filename) : image(filename) {}
 
-  color value(double u, double v, const point3& p) const override {
+  color value(real u, real v, const point3& p) const override {
     // If we have no texture data, then return solid cyan as a debugging aid.
     if (image.height() <= 0) return {0, 1, 1};
 
@@ -89,7 +89,7 @@ public:
     auto pixel = image.pixel_data(i, j);
 
     auto color_scale = 1.0 / 255.0;
-    return {color_scale * pixel[0], color_scale * pixel[1], color_scale * pixel[2]};
+    return color(color_scale * pixel[0], color_scale * pixel[1], color_scale * pixel[2]);
   }
 
 private:
@@ -99,9 +99,9 @@ private:
 class noise_texture : public texture {
   // The noise_texture class represents a noise texture.
 public:
-  explicit noise_texture(double scale) : scale(scale) {}
+  explicit noise_texture(real scale) : scale(scale) {}
 
-  color value(double u, double v, const point3& p) const override {
+  color value(real u, real v, const point3& p) const override {
 //    // 0.5 * (1.0 + noise.noise(scale * p)): map the [-1,+1] noise value to [0,1].
 //    return color(1, 1, 1) * 0.5 * (1.0 + noise.noise(scale * p));
       return color(.5, .5, .5) * (1.0 + std::sin(scale * p.z() + 10 * noise.turb(p, 7)));
@@ -109,6 +109,6 @@ public:
 
 private:
   perlin noise; // The noise object.
-  double scale; // The scale of the noise.
+  real scale; // The scale of the noise.
 };
 #endif //RAYTRACINGINONEWEEKEND_TEXTURE_H
@@ -0,0 +1,129 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: tile_scheduler.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: The tile_scheduler class splits the image into square tiles and renders them
+ * on a pool of worker threads. Every worker owns a queue of tiles and steals from the other
+ * queues once its own is empty, so expensive tiles (glass, smoke) do not leave cores idle.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_TILE_SCHEDULER_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_TILE_SCHEDULER_H_
+
+#include "rtweekend.h"
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct tile {
+  // A rectangular block of pixels [x0, x1) x [y0, y1).
+  int index;  // Position of the tile in scanline order
+  int x0, y0;
+  int x1, y1;
+};
+
+class tile_scheduler {
+ public:
+  tile_scheduler(int image_width, int image_height, int tile_size) {
+    tile_size = std::max(tile_size, 1);
+
+    for (int y = 0; y < image_height; y += tile_size) {
+      for (int x = 0; x < image_width; x += tile_size) {
+        int index = static_cast<int>(tiles.size());
+        tiles.push_back({index, x, y,
+                         std::min(x + tile_size, image_width),
+                         std::min(y + tile_size, image_height)});
+      }
+    }
+  }
+
+  [[nodiscard]] size_t tile_count() const { return tiles.size(); }
+
+  static int hardware_threads() {
+    // Returns the number of hardware threads, or 1 if it cannot be determined.
+    auto n = static_cast<int>(std::thread::hardware_concurrency());
+    return n > 0 ? n : 1;
+  }
+
+  void run(int num_threads, const std::function<void(const tile&)>& render_tile) {
+    // Render every tile exactly once using num_threads workers (0 = all hardware threads).
+    // Returns when all tiles are finished.
+    if (num_threads <= 0)
+      num_threads = hardware_threads();
+    num_threads = std::max(1, std::min(num_threads, static_cast<int>(tiles.size())));
+
+    // Deal the tiles out round-robin so that every worker starts with tiles spread over the
+    // whole image, instead of one worker getting all of the expensive region.
+    queues.clear();
+    for (int w = 0; w < num_threads; ++w)
+      queues.push_back(std::make_unique<work_queue>());
+    for (const auto& t : tiles)
+      queues[t.index % num_threads]->tiles.push_back(t.index);
+
+    if (num_threads == 1) {
+      worker_loop(0, render_tile);
+      return;
+    }
+
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads);
+    for (int w = 0; w < num_threads; ++w)
+      workers.emplace_back([this, w, &render_tile] { worker_loop(w, render_tile); });
+
+    for (auto& worker : workers)
+      worker.join();
+  }
+
+ private:
+  struct work_queue {
+    std::mutex      lock;
+    std::deque<int> tiles;
+  };
+
+  std::vector<tile>                        tiles;   // All tiles in scanline order
+  std::vector<std::unique_ptr<work_queue>> queues;  // One tile queue per worker
+
+  void worker_loop(int worker, const std::function<void(const tile&)>& render_tile) {
+    int index;
+    while (pop(worker, index) || steal(worker, index))
+      render_tile(tiles[index]);
+  }
+
+  bool pop(int worker, int& index) {
+    // The owner takes tiles from the front of its own queue.
+    auto& q = *queues[worker];
+    std::lock_guard<std::mutex> guard(q.lock);
+    if (q.tiles.empty())
+      return false;
+    index = q.tiles.front();
+    q.tiles.pop_front();
+    return true;
+  }
+
+  bool steal(int worker, int& index) {
+    // Thieves take tiles from the back of the other queues, away from where the owner works.
+    // Tiles are never added during a run, so one empty sweep means there is no work left.
+    auto n = static_cast<int>(queues.size());
+    for (int k = 1; k < n; ++k) {
+      auto& q = *queues[(worker + k) % n];
+      std::lock_guard<std::mutex> guard(q.lock);
+      if (!q.tiles.empty()) {
+        index = q.tiles.back();
+        q.tiles.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_TILE_SCHEDULER_H_
@@ -0,0 +1,142 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: transform.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: The affine_transform class is a 3x4 matrix: a linear 3x3 part followed by a
+ * translation column. It maps points (which are translated) and vectors (which are not), and
+ * bounding boxes. Transforms compose with operator*, where (a * b) applies b first, so a
+ * chain of transforms is collapsed into a single matrix before any ray is traced.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_TRANSFORM_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_TRANSFORM_H_
+
+#include "rtweekend.h"
+
+#include "AABB.h"
+
+class affine_transform {
+ public:
+  real m[3][4] = {{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}};  // Rows of the matrix
+
+  affine_transform() = default;  // The identity
+
+  static affine_transform translation(const vec3& offset) {
+    affine_transform t;
+    for (int row = 0; row < 3; ++row)
+      t.m[row][3] = offset[row];
+    return t;
+  }
+
+  static affine_transform rotation(const vec3& axis, real angle) {
+    // Rotation by angle degrees around the axis, counter-clockwise looking down the axis.
+    auto radians = degrees_to_radians(angle);
+    return rotation(unit_vector(axis), std::sin(radians), std::cos(radians));
+  }
+
+  static affine_transform rotation(const vec3& u, real sin_theta, real cos_theta) {
+    // Rotation around the unit axis u, given the sine and cosine of the angle (Rodrigues).
+    affine_transform t;
+    const real k = 1 - cos_theta;
+    t.m[0][0] = cos_theta + u.x() * u.x() * k;
+    t.m[0][1] = u.x() * u.y() * k - u.z() * sin_theta;
+    t.m[0][2] = u.x() * u.z() * k + u.y() * sin_theta;
+    t.m[1][0] = u.y() * u.x() * k + u.z() * sin_theta;
+    t.m[1][1] = cos_theta + u.y() * u.y() * k;
+    t.m[1][2] = u.y() * u.z() * k - u.x() * sin_theta;
+    t.m[2][0] = u.z() * u.x() * k - u.y() * sin_theta;
+    t.m[2][1] = u.z() * u.y() * k + u.x() * sin_theta;
+    t.m[2][2] = cos_theta + u.z() * u.z() * k;
+    return t;
+  }
+
+  static affine_transform scaling(const vec3& factors) {
+    affine_transform t;
+    for (int row = 0; row < 3; ++row)
+      t.m[row][row] = factors[row];
+    return t;
+  }
+
+  [[nodiscard]] point3 point(const point3& p) const {
+    return {m[0][0] * p.x() + m[0][1] * p.y() + m[0][2] * p.z() + m[0][3],
+            m[1][0] * p.x() + m[1][1] * p.y() + m[1][2] * p.z() + m[1][3],
+            m[2][0] * p.x() + m[2][1] * p.y() + m[2][2] * p.z() + m[2][3]};
+  }
+
+  [[nodiscard]] vec3 vector(const vec3& v) const {
+    return {m[0][0] * v.x() + m[0][1] * v.y() + m[0][2] * v.z(),
+            m[1][0] * v.x() + m[1][1] * v.y() + m[1][2] * v.z(),
+            m[2][0] * v.x() + m[2][1] * v.y() + m[2][2] * v.z()};
+  }
+
+  [[nodiscard]] vec3 transposed_vector(const vec3& v) const {
+    // The vector times the transposed linear part. Applied with the inverse transform, this
+    // maps surface normals, which stay perpendicular to the transformed surface.
+    return {m[0][0] * v.x() + m[1][0] * v.y() + m[2][0] * v.z(),
+            m[0][1] * v.x() + m[1][1] * v.y() + m[2][1] * v.z(),
+            m[0][2] * v.x() + m[1][2] * v.y() + m[2][2] * v.z()};
+  }
+
+  [[nodiscard]] AABB bounds(const AABB& box) const {
+    // The box enclosing the eight transformed corners of the box.
+    point3 min(+infinity, +infinity, +infinity);
+    point3 max(-infinity, -infinity, -infinity);
+
+    for (int i = 0; i < 2; ++i)
+      for (int j = 0; j < 2; ++j)
+        for (int k = 0; k < 2; ++k) {
+          auto corner = point(point3(i ? box.x.max : box.x.min,
+                                     j ? box.y.max : box.y.min,
+                                     k ? box.z.max : box.z.min));
+          for (int c = 0; c < 3; ++c) {
+            min[c] = std::fmin(min[c], corner[c]);
+            max[c] = std::fmax(max[c], corner[c]);
+          }
+        }
+
+    return {min, max};
+  }
+
+  [[nodiscard]] affine_transform inverse() const {
+    // The inverse of the linear part is its adjugate over its determinant; the translation
+    // is then undone in the rotated frame. The matrix must not be singular.
+    affine_transform inv;
+    inv.m[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    inv.m[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+    inv.m[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    inv.m[1][0] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    inv.m[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+    inv.m[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+    inv.m[2][0] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    inv.m[2][1] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+    inv.m[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+    const real det = m[0][0] * inv.m[0][0] + m[0][1] * inv.m[1][0] + m[0][2] * inv.m[2][0];
+    for (auto& row : inv.m)
+      for (int col = 0; col < 3; ++col)
+        row[col] /= det;
+
+    auto offset = inv.vector(vec3(m[0][3], m[1][3], m[2][3]));
+    for (int row = 0; row < 3; ++row)
+      inv.m[row][3] = -offset[row];
+    return inv;
+  }
+};
+
+inline affine_transform operator*(const affine_transform& a, const affine_transform& b) {
+  // The transform applying b, then a.
+  affine_transform t;
+  for (int row = 0; row < 3; ++row) {
+    for (int col = 0; col < 4; ++col)
+      t.m[row][col] = a.m[row][0] * b.m[0][col] + a.m[row][1] * b.m[1][col] + a.m[row][2] * b.m[2][col];
+    t.m[row][3] += a.m[row][3];
+  }
+  return t;
+}
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_TRANSFORM_H_
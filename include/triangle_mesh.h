@@ -0,0 +1,228 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: triangle_mesh.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: The triangle_mesh class is one hittable for a whole mesh of triangles. The
+ * vertex normals and texture coordinates are shared arrays, and every triangle is three
+ * 32-bit indices into each of them, so the mesh takes far fewer bytes a triangle than a heap
+ * object per triangle like tri. The mesh has a BVH of its own over the triangles, built and
+ * traversed as the flat tree of flat_bvh.h. Its leaves are runs of triangle_packs, which
+ * test a ray against several triangles at once and are the only copy of the corners (the
+ * vertex positions are dropped once they are packed), and only the closest hit of a ray
+ * fills in the hit record.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_TRIANGLE_MESH_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_TRIANGLE_MESH_H_
+
+#include "rtweekend.h"
+
+#include "AABB.h"
+#include "flat_bvh.h"
+#include "hittable.h"
+#include "material.h"
+#include "triangle_pack.h"
+
+#include <cstdint>
+#include <vector>
+
+struct mesh_uv {
+  real u, v;
+};
+
+struct mesh_data {
+  // The arrays of a mesh. The index arrays hold three indices per triangle; the normal and
+  // texture coordinate indices are empty when the mesh has no normals or coordinates.
+  std::vector<point3>   positions;
+  std::vector<vec3>     normals;
+  std::vector<mesh_uv>  uvs;
+  std::vector<uint32_t> position_indices;
+  std::vector<uint32_t> normal_indices;
+  std::vector<uint32_t> uv_indices;
+
+  [[nodiscard]] size_t triangle_count() const { return position_indices.size() / 3; }
+
+  [[nodiscard]] size_t bytes() const {
+    // Memory of the arrays.
+    return positions.size() * sizeof(point3) + normals.size() * sizeof(vec3) + uvs.size() * sizeof(mesh_uv)
+           + (position_indices.size() + normal_indices.size() + uv_indices.size()) * sizeof(uint32_t);
+  }
+};
+
+class triangle_mesh : public hittable {
+ public:
+  triangle_mesh(mesh_data data, shared_ptr<material> mat)
+      : triangle_mesh(std::move(data), std::move(mat), bvh_build_options()) {}
+
+  triangle_mesh(mesh_data data, shared_ptr<material> mat, const bvh_build_options& options)
+      : mesh(std::move(data)), mat(std::move(mat)), mat_id(this->mat ? this->mat->id() : -1)
+  {
+    build(options);
+  }
+
+  bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
+    // Closest hit, front to back as in bvh_node. The leaves only keep the pack, lane,
+    // distance and barycentric coordinates of the closest triangle so far.
+    if (nodes.empty())
+      return false;
+
+    const triangle_pack* closest = nullptr;
+    int closest_lane = 0;
+    real closest_b1 = 0, closest_b2 = 0;
+    auto hit_box = [&](uint32_t i, const interval& t, real& entry) { return nodes[i].box.hit(r, t, entry); };
+    auto hit_leaf = [&](const linear_bvh_node& leaf, interval& t) {
+      bool hit_anything = false;
+      for (uint32_t i = leaf.offset; i < leaf.offset + leaf.count; ++i) {
+        RTW_ADD(primitive_tests, packs[i].size());  // Triangles, not packs
+        real distance, b1, b2;
+        int lane = packs[i].hit(r, t, distance, b1, b2);
+        if (lane >= 0) {
+          closest = &packs[i];
+          closest_lane = lane;
+          closest_b1 = b1;
+          closest_b2 = b2;
+          t.max = distance;
+          hit_anything = true;
+        }
+      }
+      return hit_anything;
+    };
+
+    if (!hit_flat_bvh(nodes.data(), 0, ray_t, hit_box, hit_leaf))
+      return false;
+    record_hit(*closest, closest_lane, r, ray_t.max, closest_b1, closest_b2, rec);
+    return true;
+  }
+
+  [[nodiscard]] AABB bounding_box() const override {
+    return bbox;
+  }
+
+  [[nodiscard]] size_t triangle_count() const { return triangles; }
+
+  [[nodiscard]] size_t bytes() const {
+    // Memory of the mesh arrays that are kept and of the BVH.
+    return mesh.bytes() + nodes.size() * sizeof(linear_bvh_node) + packs.size() * sizeof(triangle_pack);
+  }
+
+ private:
+  mesh_data                    mesh;
+  std::vector<linear_bvh_node> nodes;  // Depth-first; leaves are ranges of packs
+  std::vector<triangle_pack>   packs;  // The triangles of the leaves, leaf by leaf
+  size_t                       triangles = 0;
+  shared_ptr<material>         mat;
+  int                          mat_id;
+  AABB                         bbox = AABB::empty;
+
+  void record_hit(const triangle_pack& pack, int lane, const ray& r, real t, real b1, real b2,
+                  hit_record& rec) const {
+    // Fills in the hit record of the closest triangle. The normals and texture coordinates
+    // of the corners are interpolated when the mesh has them; the face normal decides the
+    // side that was hit, and the interpolated normal is turned to that side, since the
+    // vertex normals of a mesh need not agree with the winding of its triangles.
+    uint32_t triangle = pack.triangle[lane];
+    vec3 e1(pack.e1[0][lane], pack.e1[1][lane], pack.e1[2][lane]);
+    vec3 e2(pack.e2[0][lane], pack.e2[1][lane], pack.e2[2][lane]);
+    vec3 face_normal = unit_vector(cross(e1, e2));
+    real b0 = 1 - b1 - b2;
+
+    rec.t = t;
+    rec.p = r.at(t);
+    rec.mat_id = mat_id;
+    rec.set_face_normal(r, face_normal);
+
+    if (!mesh.normal_indices.empty()) {
+      const uint32_t* n = &mesh.normal_indices[3 * triangle];
+      vec3 shading = unit_vector(b0 * mesh.normals[n[0]] + b1 * mesh.normals[n[1]] + b2 * mesh.normals[n[2]]);
+      if (dot(shading, rec.normal) < 0)
+        shading = -shading;
+      rec.normal = shading;
+    }
+
+    if (!mesh.uv_indices.empty()) {
+      const uint32_t* c = &mesh.uv_indices[3 * triangle];
+      rec.u = b0 * mesh.uvs[c[0]].u + b1 * mesh.uvs[c[1]].u + b2 * mesh.uvs[c[2]].u;
+      rec.v = b0 * mesh.uvs[c[0]].v + b1 * mesh.uvs[c[1]].v + b2 * mesh.uvs[c[2]].v;
+    } else {
+      rec.u = b1;
+      rec.v = b2;
+    }
+  }
+
+  void build(const bvh_build_options& options) {
+    // Builds the BVH with the splits of the options, packs the triangles of every leaf and
+    // stores their normal and texture coordinate indices in leaf order. Spans that fit in
+    // one pack are always leaves, since the pack tests them all at about the cost of a
+    // single triangle. Larger spans are split as flat_bvh_builder::build splits them (in
+    // halves once the tree gets deep), and leaves can hold at least a full pack.
+    size_t count = mesh.triangle_count();
+    if (count == 0)
+      return;
+
+    int threads = build_threads(options);
+
+    std::vector<bvh_build_primitive> prims(count);
+    parallel_for(count, threads, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        const uint32_t* corner = &mesh.position_indices[3 * i];
+        AABB box(AABB(mesh.positions[corner[0]], mesh.positions[corner[1]]),
+                 AABB(mesh.positions[corner[2]], mesh.positions[corner[2]]));
+        prims[i] = {box, box.centroid(), i, 0};
+      }
+    });
+
+    bvh_build_options pack_options = options;
+    pack_options.max_leaf_size = std::max(options.max_leaf_size, triangle_pack::width);
+
+    auto tree = build_flat_bvh<uint32_t>(prims, pack_options, threads,
+                                         [](size_t index) { return static_cast<uint32_t>(index); },
+                                         {}, triangle_pack::width);
+    nodes = std::move(tree.nodes);
+    bbox = nodes[0].box;
+    std::vector<bvh_build_primitive>().swap(prims);
+
+    auto reorder = [&](std::vector<uint32_t>& indices) {
+      if (indices.empty())
+        return;
+      std::vector<uint32_t> ordered(indices.size());
+      parallel_for(count, threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i)
+          for (int k = 0; k < 3; ++k)
+            ordered[3 * i + k] = indices[3 * tree.primitives[i] + k];
+      });
+      indices.swap(ordered);
+    };
+    reorder(mesh.normal_indices);
+    reorder(mesh.uv_indices);
+
+    // Replace the triangle range of every leaf by its packs.
+    packs.reserve(count / triangle_pack::width + nodes.size() / 2);
+    for (auto& node : nodes) {
+      if (node.count == 0)
+        continue;
+      auto first = static_cast<uint32_t>(packs.size());
+      for (uint32_t i = 0; i < node.count; ++i) {
+        if (i % triangle_pack::width == 0)
+          packs.emplace_back();
+        uint32_t triangle = node.offset + i;
+        const uint32_t* corner = &mesh.position_indices[3 * tree.primitives[triangle]];
+        packs.back().set(static_cast<int>(i % triangle_pack::width), mesh.positions[corner[0]],
+                         mesh.positions[corner[1]], mesh.positions[corner[2]], triangle);
+      }
+      node.offset = first;
+      node.count = static_cast<uint16_t>(packs.size() - first);
+    }
+
+    // The packs hold the corners of every triangle, so the positions are not kept twice.
+    triangles = count;
+    std::vector<point3>().swap(mesh.positions);
+    std::vector<uint32_t>().swap(mesh.position_indices);
+  }
+};
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_TRIANGLE_MESH_H_
@@ -0,0 +1,123 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: triangle_pack.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: The triangle_pack class stores a few triangles of a BVH leaf side by side, one
+ * per lane: the first corner and the two edges from it, coordinate by coordinate, as the lane
+ * types of simd.h load them. One ray is tested against all of them at once with the
+ * Moller-Trumbore test, without a virtual call or a branch per triangle. The width is one AVX
+ * register of real (4 doubles or 8 floats); define RTW_TRIANGLE_PACK_WIDTH to change it.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_TRIANGLE_PACK_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_TRIANGLE_PACK_H_
+
+#include "rtweekend.h"
+
+#include "simd.h"
+
+#include <cstdint>
+
+#ifdef RTW_TRIANGLE_PACK_WIDTH
+constexpr int triangle_pack_width = RTW_TRIANGLE_PACK_WIDTH;  // Triangles per pack
+#else
+constexpr int triangle_pack_width = sizeof(real) == sizeof(float) ? 8 : 4;
+#endif
+
+static_assert(triangle_pack_width >= 1 && triangle_pack_width <= 32, "pack lanes must fit an unsigned mask");
+
+class triangle_pack {
+ public:
+  using lanes = basic_lanes<real, triangle_pack_width>;
+  static constexpr int width = triangle_pack_width;
+
+  real     p0[3][width] = {};  // First corners, per axis
+  real     e1[3][width] = {};  // Edges from the first to the second corner, per axis
+  real     e2[3][width] = {};  // Edges from the first to the third corner, per axis
+  uint32_t triangle[width];    // Triangle of every lane; UINT32_MAX for the unused ones
+
+  triangle_pack() {
+    // An empty pack. Unused lanes keep zero edges, which no ray can hit.
+    for (auto& index : triangle)
+      index = UINT32_MAX;
+  }
+
+  void set(int lane, const point3& a, const point3& b, const point3& c, uint32_t index) {
+    // Puts the triangle with the corners a, b and c in a lane.
+    for (int axis = 0; axis < 3; ++axis) {
+      p0[axis][lane] = a[axis];
+      e1[axis][lane] = b[axis] - a[axis];
+      e2[axis][lane] = c[axis] - a[axis];
+    }
+    triangle[lane] = index;
+  }
+
+  [[nodiscard]] int size() const {
+    // Number of lanes in use.
+    int n = 0;
+    for (auto index : triangle)
+      n += index != UINT32_MAX;
+    return n;
+  }
+
+  int hit(const ray& r, const interval& ray_t, real& t, real& b1, real& b2) const {
+    // Returns the lane of the closest triangle the ray hits inside ray_t (the first lane of
+    // equally close ones), and its distance and barycentric coordinates, or -1 on a miss.
+    // Every lane makes the same decisions as a scalar Moller-Trumbore test of its triangle.
+    const vec3& o = r.origin();
+    const vec3& d = r.direction();
+    lanes dx(d.x()), dy(d.y()), dz(d.z());
+
+    auto e1x = lanes::load(e1[0]), e1y = lanes::load(e1[1]), e1z = lanes::load(e1[2]);
+    auto e2x = lanes::load(e2[0]), e2y = lanes::load(e2[1]), e2z = lanes::load(e2[2]);
+
+    // pvec = d x e2, det = e1 . pvec
+    auto px = dy * e2z - dz * e2y;
+    auto py = dz * e2x - dx * e2z;
+    auto pz = dx * e2y - dy * e2x;
+    auto det = e1x * px + e1y * py + e1z * pz;
+    auto inv_det = lanes(1) / det;
+
+    // tvec = o - p0, b1 = (tvec . pvec) / det
+    auto tx = lanes(o.x()) - lanes::load(p0[0]);
+    auto ty = lanes(o.y()) - lanes::load(p0[1]);
+    auto tz = lanes(o.z()) - lanes::load(p0[2]);
+    auto u = (tx * px + ty * py + tz * pz) * inv_det;
+
+    // qvec = tvec x e1, b2 = (d . qvec) / det, t = (e2 . qvec) / det
+    auto qx = ty * e1z - tz * e1y;
+    auto qy = tz * e1x - tx * e1z;
+    auto qz = tx * e1y - ty * e1x;
+    auto v = (dx * qx + dy * qy + dz * qz) * inv_det;
+    auto dist = (e2x * qx + e2y * qy + e2z * qz) * inv_det;
+
+    // The comparisons are false for the NaNs of a zero determinant, which is excluded too.
+    auto inside = ~(det == lanes(0)) & (u >= lanes(0)) & (v >= lanes(0)) & (u + v <= lanes(1))
+                & (dist > lanes(ray_t.min)) & (dist < lanes(ray_t.max));
+    unsigned hits = inside.bits();
+    if (!hits)
+      return -1;
+
+    real ts[width], us[width], vs[width];
+    dist.store(ts);
+    u.store(us);
+    v.store(vs);
+
+    int closest = -1;
+    for (int lane = 0; lane < width; ++lane)
+      if ((hits & (1u << lane)) && (closest < 0 || ts[lane] < ts[closest]))
+        closest = lane;
+
+    t = ts[closest];
+    b1 = us[closest];
+    b2 = vs[closest];
+    return closest;
+  }
+};
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_TRIANGLE_PACK_H_
@@ -16,51 +16,58 @@
 
 #include "rtweekend.h"
 
-class vec3 {
+template <typename T>
+class basic_vec3 {
 public :
-    double  e[3];
+    using scalar_type = T;
 
-    vec3() : e{0, 0, 0} {}
-    vec3(double e0, double e1, double e2) : e{e0, e1, e2} {}
+    T  e[3];
 
-    double x() const { return e[0]; }
-    double y() const { return e[1]; }
-    double z() const { return e[2]; }
+    basic_vec3() : e{0, 0, 0} {}
+    basic_vec3(T e0, T e1, T e2) : e{e0, e1, e2} {}
 
-    vec3 operator-() const { return {-e[0], -e[1], -e[2]}; }
-    double operator[](int i) const { return e[i]; }
-    double& operator[](int i) { return e[i]; }
+    // Converts between scalar types, e.g. to accumulate float colors in double.
+    template <typename U>
+    explicit basic_vec3(const basic_vec3<U>& v) : e{T(v.e[0]), T(v.e[1]), T(v.e[2])} {}
 
-    vec3& operator+=(const vec3 &v) {
+    T x() const { return e[0]; }
+    T y() const { return e[1]; }
+    T z() const { return e[2]; }
+
+    basic_vec3 operator-() const { return {-e[0], -e[1], -e[2]}; }
+    T operator[](int i) const { return e[i]; }
+    T& operator[](int i) { return e[i]; }
+
+    basic_vec3& operator+=(const basic_vec3 &v) {
         e[0] += v.e[0];
         e[1] += v.e[1];
         e[2] += v.e[2];
         return *this;
     }
 
-    vec3& operator*=(const vec3 &v) {
+    basic_vec3& operator*=(const basic_vec3 &v) {
         e[0] *= v.e[0];
         e[1] *= v.e[1];
         e[2] *= v.e[2];
         return *this;
     }
 
-    vec3& operator*=(const double t) {
+    basic_vec3& operator*=(const T t) {
         e[0] *= t;
         e[1] *= t;
         e[2] *= t;
         return *this;
     }
 
-    vec3& operator/=(const double t) {
-        return *this *= 1/t;
+    basic_vec3& operator/=(const T t) {
+        return *this *= T(1)/t;
     }
 
-    double length() const {
+    T length() const {
         return std::sqrt(length_squared());
     }
 
-    double length_squared() const {
+    T length_squared() const {
         return e[0]*e[0] + e[1]*e[1] + e[2]*e[2];
     }
 
@@ -70,64 +77,77 @@ public :
         return (std::fabs(e[0]) < s) && (std::fabs(e[1]) < s) && (std::fabs(e[2]) < s);
     }
 
-    static vec3 random() {
+    static basic_vec3 random() {
         // Generate arbitrary random vectors.
-        return {random_double(), random_double(), random_double()};
+        return {T(random_double()), T(random_double()), T(random_double())};
     }
 
-    static vec3 random(double min, double max) {
+    static basic_vec3 random(double min, double max) {
         // Generate a random vector with each component in the range [min, max).
-        return {random_double(min, max),
-                    random_double(min, max), random_double(min, max)};
+        return {T(random_double(min, max)),
+                    T(random_double(min, max)), T(random_double(min, max))};
     }
 };
 
+using vec3 = basic_vec3<real>;
 using point3 = vec3;
 
 
 // vec3 Utility Functions
+// The scalar operands are declared as scalar_type, which is not deduced, so that double
+// constants and expressions can be combined with float vectors.
 
-inline std::ostream & operator<<(std::ostream &out, const vec3 &v) {
+template <typename T>
+inline std::ostream & operator<<(std::ostream &out, const basic_vec3<T> &v) {
     return out << v.e[0] << ' ' << v.e[1] << ' ' << v.e[2];
 }
 
-inline vec3 operator+(const vec3 &u, const vec3 &v) {
+template <typename T>
+inline basic_vec3<T> operator+(const basic_vec3<T> &u, const basic_vec3<T> &v) {
     return {u.e[0] + v.e[0], u.e[1] + v.e[1], u.e[2] + v.e[2]};
 }
 
-inline vec3 operator-(const vec3 &u, const vec3 &v) {
+template <typename T>
+inline basic_vec3<T> operator-(const basic_vec3<T> &u, const basic_vec3<T> &v) {
     return {u.e[0] - v.e[0], u.e[1] - v.e[1], u.e[2] - v.e[2]};
 }
 
-inline vec3 operator*(const vec3 &u, const vec3 &v) {
+template <typename T>
+inline basic_vec3<T> operator*(const basic_vec3<T> &u, const basic_vec3<T> &v) {
     return {u.e[0] * v.e[0], u.e[1] * v.e[1], u.e[2] * v.e[2]};
 }
 
-inline vec3 operator*(double t, const vec3 &v) {
+template <typename T>
+inline basic_vec3<T> operator*(typename basic_vec3<T>::scalar_type t, const basic_vec3<T> &v) {
     return {t*v.e[0], t*v.e[1], t*v.e[2]};
 }
 
-inline vec3 operator*(const vec3 &v, double t) {
+template <typename T>
+inline basic_vec3<T> operator*(const basic_vec3<T> &v, typename basic_vec3<T>::scalar_type t) {
     return t * v;
 }
 
-inline vec3 operator/(vec3 v, double t) {
-    return (1/t) * v;
+template <typename T>
+inline basic_vec3<T> operator/(basic_vec3<T> v, typename basic_vec3<T>::scalar_type t) {
+    return (T(1)/t) * v;
 }
 
-inline double dot(const vec3 &u, const vec3 &v) {
+template <typename T>
+inline T dot(const basic_vec3<T> &u, const basic_vec3<T> &v) {
     return u.e[0] * v.e[0]
          + u.e[1] * v.e[1]
          + u.e[2] * v.e[2];
 }
 
-inline vec3 cross(const vec3 &u, const vec3 &v) {
+template <typename T>
+inline basic_vec3<T> cross(const basic_vec3<T> &u, const basic_vec3<T> &v) {
     return {u.e[1] * v.e[2] - u.e[2] * v.e[1],
                 u.e[2] * v.e[0] - u.e[0] * v.e[2],
                 u.e[0] * v.e[1] - u.e[1] * v.e[0]};
 }
 
-inline vec3 unit_vector(vec3 v) {
+template <typename T>
+inline basic_vec3<T> unit_vector(basic_vec3<T> v) {
     // Returns the unit vector of v.
     return v / v.length();
 }
@@ -173,7 +193,7 @@ inline vec3 random_cosine_direction() {
     auto y = std::sin(phi) * std::sqrt(r2);
     auto z = std::sqrt(1 - r2);
 
-    return {x, y, z};
+    return vec3(x, y, z);
 }
 
 inline vec3 reflect(const vec3& v, const vec3& n) {
@@ -0,0 +1,226 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: vec3_simd.h
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: SIMD forms of vec3, built on the lane types of simd.h.
+ * basic_vec3a is one vector padded to four aligned lanes (x, y, z, 0), so that a whole vector
+ * is one register operation. basic_vec3x holds N vectors in SoA form, one lane type per
+ * coordinate, so that N rays, normals or directions are processed with the same code as one
+ * vec3. Both offer the operations of vec3 (dot, cross, unit_vector, reflect, refract) plus
+ * lane-wise min, max and select.
+ */
+
+#ifndef RAYTRACINGINONEWEEKEND_INCLUDE_VEC3_SIMD_H_
+#define RAYTRACINGINONEWEEKEND_INCLUDE_VEC3_SIMD_H_
+
+#include "rtweekend.h"
+
+#include "simd.h"
+
+template <typename T>
+class basic_vec3a {
+ public:
+  using lanes_type = basic_lanes<T, 4>;
+
+  lanes_type e;  // x, y, z and a zero
+
+  basic_vec3a() = default;
+  explicit basic_vec3a(const lanes_type& e) : e(e) {}
+  basic_vec3a(T x, T y, T z) {
+    T v[4] = {x, y, z, 0};
+    e = lanes_type::load(v);
+  }
+  explicit basic_vec3a(const basic_vec3<T>& v) : basic_vec3a(v.x(), v.y(), v.z()) {}
+
+  [[nodiscard]] T x() const { return e.lane(0); }
+  [[nodiscard]] T y() const { return e.lane(1); }
+  [[nodiscard]] T z() const { return e.lane(2); }
+
+  [[nodiscard]] basic_vec3<T> to_vec3() const {
+    T v[4];
+    e.store(v);
+    return {v[0], v[1], v[2]};
+  }
+
+  [[nodiscard]] T length_squared() const { return reduce_add(e * e); }
+  [[nodiscard]] T length() const { return std::sqrt(length_squared()); }
+};
+
+using vec3a = basic_vec3a<real>;
+
+template <typename T>
+inline basic_vec3a<T> operator+(const basic_vec3a<T>& u, const basic_vec3a<T>& v) { return basic_vec3a<T>(u.e + v.e); }
+template <typename T>
+inline basic_vec3a<T> operator-(const basic_vec3a<T>& u, const basic_vec3a<T>& v) { return basic_vec3a<T>(u.e - v.e); }
+template <typename T>
+inline basic_vec3a<T> operator*(const basic_vec3a<T>& u, const basic_vec3a<T>& v) { return basic_vec3a<T>(u.e * v.e); }
+template <typename T>
+inline basic_vec3a<T> operator-(const basic_vec3a<T>& v) { return basic_vec3a<T>(-v.e); }
+
+template <typename T>
+inline basic_vec3a<T> operator*(typename basic_vec3<T>::scalar_type t, const basic_vec3a<T>& v) {
+  return basic_vec3a<T>(basic_lanes<T, 4>(t) * v.e);
+}
+
+template <typename T>
+inline basic_vec3a<T> operator/(const basic_vec3a<T>& v, typename basic_vec3<T>::scalar_type t) {
+  return (T(1) / t) * v;
+}
+
+template <typename T>
+inline T dot(const basic_vec3a<T>& u, const basic_vec3a<T>& v) {
+  return reduce_add(u.e * v.e);
+}
+
+template <typename T>
+inline basic_vec3a<T> cross(const basic_vec3a<T>& u, const basic_vec3a<T>& v) {
+  // u x v = yzx(u * yzx(v) - yzx(u) * v); the zero w lane stays zero.
+  return basic_vec3a<T>(yzxw(u.e * yzxw(v.e) - yzxw(u.e) * v.e));
+}
+
+template <typename T>
+inline basic_vec3a<T> unit_vector(const basic_vec3a<T>& v) {
+  return v / v.length();
+}
+
+template <typename T>
+inline basic_vec3a<T> min(const basic_vec3a<T>& u, const basic_vec3a<T>& v) { return basic_vec3a<T>(min(u.e, v.e)); }
+template <typename T>
+inline basic_vec3a<T> max(const basic_vec3a<T>& u, const basic_vec3a<T>& v) { return basic_vec3a<T>(max(u.e, v.e)); }
+
+template <typename T>
+inline basic_vec3a<T> reflect(const basic_vec3a<T>& v, const basic_vec3a<T>& n) {
+  // Reflects a vector v around a normal n.
+  return v - 2 * dot(v, n) * n;
+}
+
+template <typename T>
+inline basic_vec3a<T> refract(const basic_vec3a<T>& uv, const basic_vec3a<T>& n, T etai_over_etat) {
+  // Refracts a vector uv around a normal n.
+  auto cos_theta = std::fmin(dot(-uv, n), T(1));
+  auto r_out_perp = etai_over_etat * (uv + cos_theta * n);
+  auto r_out_parallel = -std::sqrt(std::fabs(1 - r_out_perp.length_squared())) * n;
+  return r_out_perp + r_out_parallel;
+}
+
+template <typename T, int N>
+class basic_vec3x {
+ public:
+  using lanes_type = basic_lanes<T, N>;
+  using mask_type = typename lanes_type::mask_type;
+  static constexpr int width = N;
+
+  lanes_type x, y, z;  // One coordinate of every vector per lane type
+
+  basic_vec3x() = default;
+  basic_vec3x(const lanes_type& x, const lanes_type& y, const lanes_type& z) : x(x), y(y), z(z) {}
+  explicit basic_vec3x(const basic_vec3<T>& v) : x(v.x()), y(v.y()), z(v.z()) {}
+
+  static basic_vec3x load(const T* xs, const T* ys, const T* zs) {
+    // Loads N vectors from coordinate arrays.
+    return {lanes_type::load(xs), lanes_type::load(ys), lanes_type::load(zs)};
+  }
+
+  void store(T* xs, T* ys, T* zs) const {
+    x.store(xs);
+    y.store(ys);
+    z.store(zs);
+  }
+
+  [[nodiscard]] basic_vec3<T> lane(int i) const { return {x.lane(i), y.lane(i), z.lane(i)}; }
+
+  [[nodiscard]] lanes_type length_squared() const { return x * x + y * y + z * z; }
+  [[nodiscard]] lanes_type length() const { return sqrt(length_squared()); }
+};
+
+using vec3x4 = basic_vec3x<real, 4>;
+using vec3x8 = basic_vec3x<real, 8>;
+
+template <typename T, int N>
+inline basic_vec3x<T, N> operator+(const basic_vec3x<T, N>& u, const basic_vec3x<T, N>& v) {
+  return {u.x + v.x, u.y + v.y, u.z + v.z};
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> operator-(const basic_vec3x<T, N>& u, const basic_vec3x<T, N>& v) {
+  return {u.x - v.x, u.y - v.y, u.z - v.z};
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> operator*(const basic_vec3x<T, N>& u, const basic_vec3x<T, N>& v) {
+  return {u.x * v.x, u.y * v.y, u.z * v.z};
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> operator-(const basic_vec3x<T, N>& v) {
+  return {-v.x, -v.y, -v.z};
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> operator*(const typename basic_vec3x<T, N>::lanes_type& t, const basic_vec3x<T, N>& v) {
+  // Scales every vector by its own lane of t (or by one scalar, which broadcasts).
+  return {t * v.x, t * v.y, t * v.z};
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> operator/(const basic_vec3x<T, N>& v, const typename basic_vec3x<T, N>::lanes_type& t) {
+  return (typename basic_vec3x<T, N>::lanes_type(1) / t) * v;
+}
+
+template <typename T, int N>
+inline basic_lanes<T, N> dot(const basic_vec3x<T, N>& u, const basic_vec3x<T, N>& v) {
+  return u.x * v.x + u.y * v.y + u.z * v.z;
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> cross(const basic_vec3x<T, N>& u, const basic_vec3x<T, N>& v) {
+  return {u.y * v.z - u.z * v.y,
+          u.z * v.x - u.x * v.z,
+          u.x * v.y - u.y * v.x};
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> unit_vector(const basic_vec3x<T, N>& v) {
+  return v / v.length();
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> min(const basic_vec3x<T, N>& u, const basic_vec3x<T, N>& v) {
+  return {min(u.x, v.x), min(u.y, v.y), min(u.z, v.z)};
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> max(const basic_vec3x<T, N>& u, const basic_vec3x<T, N>& v) {
+  return {max(u.x, v.x), max(u.y, v.y), max(u.z, v.z)};
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> select(const typename basic_vec3x<T, N>::mask_type& m,
+                                const basic_vec3x<T, N>& u, const basic_vec3x<T, N>& v) {
+  // u in the lanes of the mask, v in the others.
+  return {select(m, u.x, v.x), select(m, u.y, v.y), select(m, u.z, v.z)};
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> reflect(const basic_vec3x<T, N>& v, const basic_vec3x<T, N>& n) {
+  // Reflects every vector v around its normal n.
+  return v - (2 * dot(v, n)) * n;
+}
+
+template <typename T, int N>
+inline basic_vec3x<T, N> refract(const basic_vec3x<T, N>& uv, const basic_vec3x<T, N>& n,
+                                 const typename basic_vec3x<T, N>::lanes_type& etai_over_etat) {
+  // Refracts every vector uv around its normal n.
+  using lanes_type = basic_lanes<T, N>;
+  auto cos_theta = min(dot(-uv, n), lanes_type(1));
+  auto r_out_perp = etai_over_etat * (uv + cos_theta * n);
+  auto r_out_parallel = -sqrt(abs(lanes_type(1) - r_out_perp.length_squared())) * n;
+  return r_out_perp + r_out_parallel;
+}
+
+#endif //RAYTRACINGINONEWEEKEND_INCLUDE_VEC3_SIMD_H_
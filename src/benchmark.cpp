@@ -0,0 +1,1240 @@
+//
+// Created by ASUS on 2026/10/18.
+//
+/************************
+ * @Author: Magical1
+ * @Time: 2026/10/18 20:00
+ * @File: benchmark.cpp
+ * @Software: CLion
+ * @Project: RayTracingInOneWeekend
+ * @Description: Performance benchmarks for the renderer.
+ * Usage: benchmark [name]  (runs all benchmarks when no name is given)
+ * The scenes come from scenes.h, shrunk to a small image and sample count so that every
+ * benchmark finishes in seconds. Results are written to std::cout.
+ * The BVH traversal counters of stats.h are compiled in; they cost every variant alike.
+ */
+
+#define RTW_TRAVERSAL_STATS
+
+#include "rtweekend.h"
+
+#include "obj_loader.h"
+#include "scenes.h"
+#include "vec3_simd.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using bench_clock = std::chrono::steady_clock;
+
+// Every heap allocation of the benchmark process goes through these counters: all the
+// replaceable forms of operator new and delete are replaced, plain, array, aligned and
+// nothrow, so that over-aligned types such as linear_bvh_node are counted too.
+std::atomic<long long> allocation_count{0};
+std::atomic<long long> allocation_bytes{0};
+
+// GCC pairs every inlined new with a matching delete and flags the malloc and free inside
+// them as mismatched, though the replacements below allocate and free consistently.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* counted_allocate(std::size_t size, std::size_t alignment) noexcept {
+  // Counts an allocation and returns its block, or null. Over-aligned blocks are carved
+  // out of a larger malloc block, with the pointer to free stored just below them.
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocation_bytes.fetch_add(static_cast<long long>(size), std::memory_order_relaxed);
+  if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    return std::malloc(size ? size : 1);
+
+  void* block = std::malloc(size + alignment + sizeof(void*));
+  if (!block)
+    return nullptr;
+  auto address = reinterpret_cast<std::uintptr_t>(block) + sizeof(void*);
+  auto aligned = reinterpret_cast<void**>((address + alignment - 1) & ~(std::uintptr_t(alignment) - 1));
+  aligned[-1] = block;
+  return aligned;
+}
+
+void counted_free(void* p, std::size_t alignment) noexcept {
+  // Frees a block of counted_allocate with the same alignment.
+  if (p && alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+    p = static_cast<void**>(p)[-1];
+  std::free(p);
+}
+
+void* counted_new(std::size_t size, std::size_t alignment) {
+  // counted_allocate for the throwing forms of new.
+  if (void* p = counted_allocate(size, alignment))
+    return p;
+  throw std::bad_alloc();
+}
+
+constexpr std::size_t default_alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+void* operator new(std::size_t size) { return counted_new(size, default_alignment); }
+void* operator new[](std::size_t size) { return counted_new(size, default_alignment); }
+void* operator new(std::size_t size, std::align_val_t a) { return counted_new(size, std::size_t(a)); }
+void* operator new[](std::size_t size, std::align_val_t a) { return counted_new(size, std::size_t(a)); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return counted_allocate(size, default_alignment);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return counted_allocate(size, default_alignment);
+}
+void* operator new(std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept {
+  return counted_allocate(size, std::size_t(a));
+}
+void* operator new[](std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept {
+  return counted_allocate(size, std::size_t(a));
+}
+
+void operator delete(void* p) noexcept { counted_free(p, default_alignment); }
+void operator delete[](void* p) noexcept { counted_free(p, default_alignment); }
+void operator delete(void* p, std::size_t) noexcept { counted_free(p, default_alignment); }
+void operator delete[](void* p, std::size_t) noexcept { counted_free(p, default_alignment); }
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+  counted_free(p, default_alignment);
+}
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  counted_free(p, default_alignment);
+}
+void operator delete(void* p, std::align_val_t a) noexcept { counted_free(p, std::size_t(a)); }
+void operator delete[](void* p, std::align_val_t a) noexcept { counted_free(p, std::size_t(a)); }
+void operator delete(void* p, std::size_t, std::align_val_t a) noexcept {
+  counted_free(p, std::size_t(a));
+}
+void operator delete[](void* p, std::size_t, std::align_val_t a) noexcept {
+  counted_free(p, std::size_t(a));
+}
+void operator delete(void* p, std::align_val_t a, const std::nothrow_t&) noexcept {
+  counted_free(p, std::size_t(a));
+}
+void operator delete[](void* p, std::align_val_t a, const std::nothrow_t&) noexcept {
+  counted_free(p, std::size_t(a));
+}
+
+struct named_scene {
+  const char*                                    name;
+  std::function<scene(const bvh_build_options&)> build;  // Builds the scene with these BVH options
+};
+
+scene small_final_scene(const bvh_build_options& options) {
+  // final_scene at the size the benchmarks render it.
+  return final_scene(400, 250, 4, options);
+}
+
+std::vector<named_scene> benchmark_scenes() {
+  // The scenes used by the render benchmarks.
+  return {
+      {"bouncing_spheres", bouncing_spheres},
+      {"cornell_box",      cornell_box},
+  };
+}
+
+void scale_down(scene& s, int image_width, int samples_per_pixel) {
+  // Shrink the render settings of a scene, keeping its camera and aspect ratio.
+  s.cam.image_width       = image_width;
+  s.cam.samples_per_pixel = samples_per_pixel;
+}
+
+double time_render(scene& s, framebuffer& image, int repeats = 3) {
+  // Returns the best wall time of several renders, in seconds.
+  double best = infinity;
+  for (int k = 0; k < repeats; ++k) {
+    auto start = bench_clock::now();
+    image = s.cam.render_image(s.world, s.lights);
+    std::chrono::duration<double> elapsed = bench_clock::now() - start;
+    best = std::fmin(best, elapsed.count());
+  }
+  return best;
+}
+
+bool identical(const framebuffer& a, const framebuffer& b) {
+  // Compare two images bit for bit.
+  if (a.width() != b.width() || a.height() != b.height())
+    return false;
+
+  for (int j = 0; j < a.height(); ++j)
+    for (int i = 0; i < a.width(); ++i)
+      if (std::memcmp(&a.at(i, j), &b.at(i, j), sizeof(color)) != 0)
+        return false;
+
+  return true;
+}
+
+void bench_determinism() {
+  // Cost of keying every sample's random stream by (pixel, sample), and a check that the
+  // deterministic image does not depend on the thread count or the tile size.
+  std::cout << "== determinism ==\n";
+
+  for (const auto& entry : benchmark_scenes()) {
+    auto s = entry.build({});
+    scale_down(s, 160, 64);
+
+    framebuffer free_image, det_image, det_single;
+
+    // Alternate the two modes so that both see the same machine load.
+    double free_time = infinity, det_time = infinity;
+    for (int k = 0; k < 3; ++k) {
+      s.cam.deterministic = false;
+      free_time = std::fmin(free_time, time_render(s, free_image, 1));
+      s.cam.deterministic = true;
+      det_time = std::fmin(det_time, time_render(s, det_image, 1));
+    }
+
+    s.cam.num_threads = 1;
+    s.cam.tile_size   = 7;
+    time_render(s, det_single, 1);
+
+    std::cout << std::setw(18) << entry.name
+              << "  default " << free_time << "s"
+              << "  deterministic " << det_time << "s"
+              << "  overhead " << 100.0 * (det_time - free_time) / free_time << "%"
+              << "  thread-independent: " << (identical(det_image, det_single) ? "yes" : "NO")
+              << '\n';
+  }
+}
+
+void bench_progressive() {
+  // Latency of the first pass of a progressive render compared with a one-pass render of
+  // the same samples, and a check that the passes add up to exactly the one-pass image.
+  std::cout << "== progressive ==\n";
+
+  for (const auto& entry : benchmark_scenes()) {
+    auto s = entry.build({});
+    scale_down(s, 160, 64);
+    s.cam.deterministic = true;
+
+    framebuffer full_image, pass_image;
+
+    s.cam.samples_per_pass = 0;
+    auto full_time = time_render(s, full_image, 1);
+
+    // The first pass is timed inside the progressive render itself.
+    const int pass_samples = 7;
+    s.cam.samples_per_pass = pass_samples;
+    double first_pass_time = 0;
+    auto start = bench_clock::now();
+    s.cam.pass_callback = [&](int pass, int) {
+      if (pass == 1)
+        first_pass_time = std::chrono::duration<double>(bench_clock::now() - start).count();
+    };
+    auto pass_time = time_render(s, pass_image, 1);
+    s.cam.pass_callback = nullptr;
+
+    std::cout << std::setw(18) << entry.name
+              << "  one pass " << full_time << "s"
+              << "  progressive " << pass_time << "s"
+              << "  first pass (" << pass_samples << " of 64 spp) " << first_pass_time << "s"
+              << "  passes match one-pass image: "
+              << (identical(full_image, pass_image) ? "yes" : "NO") << '\n';
+  }
+}
+
+double display_rmse(const framebuffer& a, const framebuffer& b) {
+  // Root mean square difference of two images after gamma correction and clamping,
+  // i.e. of the values that end up in the output file.
+  static const interval intensity(0.000, 0.999);
+  double sum = 0;
+  for (int j = 0; j < a.height(); ++j) {
+    for (int i = 0; i < a.width(); ++i) {
+      for (int c = 0; c < 3; ++c) {
+        auto d = intensity.clamp(linear_to_gamma(a.at(i, j)[c]))
+               - intensity.clamp(linear_to_gamma(b.at(i, j)[c]));
+        sum += d * d;
+      }
+    }
+  }
+  return std::sqrt(sum / (3.0 * a.width() * a.height()));
+}
+
+void bench_adaptive() {
+  // Image error and wall time of uniform sampling against adaptive sampling with the same
+  // sample budget, measured against a high sample count reference.
+  std::cout << "== adaptive ==\n";
+
+  for (const auto& entry : benchmark_scenes()) {
+    auto s = entry.build({});
+    scale_down(s, 64, 2048);
+
+    framebuffer reference, uniform;
+    time_render(s, reference, 1);
+
+    s.cam.samples_per_pixel = 256;
+    auto uniform_time = time_render(s, uniform, 1);
+    std::cout << std::setw(18) << entry.name << "  uniform  256 spp     "
+              << uniform_time << "s  rmse " << display_rmse(uniform, reference) << '\n';
+
+    for (double threshold : {0.05, 0.1}) {
+      s.cam.adaptive_threshold = threshold;
+
+      auto start = bench_clock::now();
+      auto accum = s.cam.render_film(s.world, s.lights);
+      std::chrono::duration<double> adaptive_time = bench_clock::now() - start;
+
+      std::cout << std::setw(18) << entry.name << "  adaptive " << threshold << " threshold "
+                << adaptive_time.count() << "s  rmse " << display_rmse(accum.resolve(), reference)
+                << "  (" << double(accum.total_samples()) / (accum.width() * accum.height())
+                << " spp avg)\n";
+    }
+  }
+}
+
+double mean_luminance(const framebuffer& image) {
+  // Average linear luminance of an image; a biased estimator shows up as a shift here.
+  // NaN pixels (e.g. light sampling in scenes without lights) count as black, as in the output.
+  double sum = 0;
+  for (int j = 0; j < image.height(); ++j)
+    for (int i = 0; i < image.width(); ++i) {
+      double lum = 0.2126 * image.at(i, j).x() + 0.7152 * image.at(i, j).y() + 0.0722 * image.at(i, j).z();
+      if (lum == lum)
+        sum += lum;
+    }
+  return sum / (image.width() * image.height());
+}
+
+void bench_roulette() {
+  // Russian roulette against the fixed depth cutoff in the closed Cornell scenes: wall time,
+  // image error and mean brightness (a low max_depth darkens the image, roulette must not).
+  std::cout << "== roulette ==\n";
+
+  std::vector<named_scene> scenes = {
+      {"cornell_box",   cornell_box},
+      {"cornell_smoke", cornell_smoke},
+  };
+
+  for (const auto& entry : scenes) {
+    auto s = entry.build({});
+    scale_down(s, 64, 1024);
+    s.cam.russian_roulette = false;
+
+    framebuffer reference, image;
+    time_render(s, reference, 1);
+    std::cout << std::setw(18) << entry.name << "  reference mean " << mean_luminance(reference) << '\n';
+
+    struct variant { const char* name; bool roulette; int max_depth; };
+    for (auto v : {variant{"depth 50       ", false, 50},
+                   variant{"depth 4        ", false, 4},
+                   variant{"roulette      ", true, 50}}) {
+      s.cam.samples_per_pixel = 256;
+      s.cam.russian_roulette  = v.roulette;
+      s.cam.max_depth         = v.max_depth;
+      auto t = time_render(s, image, 1);
+
+      std::cout << std::setw(18) << entry.name << "  " << v.name << t << "s"
+                << "  rmse " << display_rmse(image, reference)
+                << "  mean " << mean_luminance(image) << '\n';
+    }
+  }
+}
+
+void bench_wavefront() {
+  // Wall time of the per-sample path engine against the wavefront engine, and a check that
+  // both trace exactly the same paths.
+  std::cout << "== wavefront ==\n";
+
+  std::vector<named_scene> scenes = benchmark_scenes();
+  scenes.push_back({"final_scene", small_final_scene});
+
+  for (const auto& entry : scenes) {
+    auto s = entry.build({});
+    scale_down(s, 160, 64);
+    s.cam.deterministic = true;
+
+    framebuffer path_image, wavefront_image;
+
+    double path_time = infinity, wavefront_time = infinity;
+    for (int k = 0; k < 3; ++k) {
+      s.cam.engine = render_engine::path;
+      path_time = std::fmin(path_time, time_render(s, path_image, 1));
+      s.cam.engine = render_engine::wavefront;
+      wavefront_time = std::fmin(wavefront_time, time_render(s, wavefront_image, 1));
+    }
+
+    std::cout << std::setw(18) << entry.name
+              << "  path " << path_time << "s"
+              << "  wavefront " << wavefront_time << "s"
+              << "  speedup " << path_time / wavefront_time << "x"
+              << "  same image: " << (identical(path_image, wavefront_image) ? "yes" : "NO")
+              << '\n';
+  }
+}
+
+void bench_packets() {
+  // Camera ray throughput of the wavefront engine with single rays and with ray packets
+  // (max_depth 1, so only camera rays are traced), the full render time with both, and a
+  // check that packets find exactly the same hits.
+  std::cout << "== packets (" << packet_width << " lanes) ==\n";
+
+  std::vector<named_scene> scenes = {
+      {"bouncing_spheres", bouncing_spheres},
+      {"quads",            quads},
+      {"cornell_box",      cornell_box},
+  };
+
+  for (const auto& entry : scenes) {
+    auto s = entry.build({});
+    scale_down(s, 160, 64);
+    s.cam.engine = render_engine::wavefront;
+    int max_depth = s.cam.max_depth;
+
+    framebuffer single_image, packet_image;
+    bool same = true;
+    double single_time[2] = {infinity, infinity}, packet_time[2] = {infinity, infinity};
+
+    for (int depth : {1, max_depth}) {
+      int k = depth == 1 ? 0 : 1;
+      s.cam.max_depth = depth;
+      for (int repeat = 0; repeat < 3; ++repeat) {
+        s.cam.packet_tracing = false;
+        single_time[k] = std::fmin(single_time[k], time_render(s, single_image, 1));
+        s.cam.packet_tracing = true;
+        packet_time[k] = std::fmin(packet_time[k], time_render(s, packet_image, 1));
+      }
+      same = same && identical(single_image, packet_image);
+    }
+
+    auto image_height = static_cast<int>(s.cam.image_width / s.cam.aspect_ratio);
+    auto rays = double(s.cam.image_width) * std::max(1, image_height) * s.cam.samples_per_pixel;
+
+    std::cout << std::setw(18) << entry.name
+              << "  camera rays: single " << rays / single_time[0] / 1e6 << " Mray/s"
+              << "  packets " << rays / packet_time[0] / 1e6 << " Mray/s"
+              << "  full render: single " << single_time[1] << "s"
+              << "  packets " << packet_time[1] << "s"
+              << "  same image: " << (same ? "yes" : "NO") << '\n';
+  }
+}
+
+void bench_output() {
+  // Time and size of writing a 1200x675 image: the former per-pixel write_color stream
+  // insertions against the bulk P3, P6 and PFM writers, plus a check that the new P3 text
+  // is byte for byte the old one.
+  std::cout << "== output ==\n";
+
+  framebuffer image(1200, 675);
+  seed_random(pcg32::default_seed);
+  for (int j = 0; j < image.height(); ++j)
+    for (int i = 0; i < image.width(); ++i)
+      image.at(i, j) = 1.5 * color::random();  // Some components are over-exposed
+
+  auto time_write = [&](const char* name, const std::function<void(std::ostream&)>& write) {
+    std::string bytes;
+    double best = infinity;
+    for (int k = 0; k < 5; ++k) {
+      std::ostringstream out;
+      auto start = bench_clock::now();
+      write(out);
+      std::chrono::duration<double> elapsed = bench_clock::now() - start;
+      best = std::fmin(best, elapsed.count());
+      bytes = out.str();
+    }
+    std::cout << std::setw(18) << name << "  " << 1000 * best << "ms  "
+              << bytes.size() / 1024 << " KiB\n";
+    return bytes;
+  };
+
+  auto old_p3 = time_write("write_color P3", [&](std::ostream& out) {
+    out << "P3\n" << image.width() << ' ' << image.height() << "\n255\n";
+    for (int j = 0; j < image.height(); ++j)
+      for (int i = 0; i < image.width(); ++i)
+        write_color(out, image.at(i, j));
+  });
+  auto new_p3 = time_write("bulk P3", [&](std::ostream& out) { image.write(out, image_format::ppm_ascii); });
+  time_write("P6", [&](std::ostream& out) { image.write(out, image_format::ppm_binary); });
+  time_write("PFM", [&](std::ostream& out) { image.write(out, image_format::pfm); });
+
+  std::cout << std::setw(18) << "P3 output matches: " << (old_p3 == new_p3 ? "yes" : "NO") << '\n';
+}
+
+void bench_allocations() {
+  // Heap allocations per traced path, i.e. what shading costs the allocator beyond the
+  // fixed per-render setup (the setup is measured with a single sample and subtracted).
+  std::cout << "== allocations ==\n";
+
+  std::vector<named_scene> scenes = benchmark_scenes();
+  scenes.push_back({"cornell_smoke", cornell_smoke});
+
+  for (const auto& entry : scenes) {
+    auto s = entry.build({});
+    scale_down(s, 64, 1);
+    s.cam.num_threads = 1;
+
+    framebuffer image;
+    auto before = allocation_count.load();
+    time_render(s, image, 1);
+    auto setup = allocation_count.load() - before;
+
+    s.cam.samples_per_pixel = 64;
+    before = allocation_count.load();
+    auto t = time_render(s, image, 1);
+    auto total = allocation_count.load() - before;
+
+    auto paths = 63.0 * image.width() * image.height();
+    std::cout << std::setw(18) << entry.name << "  " << (total - setup) / paths
+              << " allocations per path  (" << t << "s)\n";
+  }
+}
+
+void bench_scaling() {
+  // Render time with 1, 2, 4, ... threads up to the hardware thread count, and the speedup
+  // over one thread; shared state touched per hit or per bounce shows up as lost speedup.
+  std::cout << "== scaling (" << tile_scheduler::hardware_threads() << " hardware threads) ==\n";
+
+  for (const auto& entry : benchmark_scenes()) {
+    auto s = entry.build({});
+    scale_down(s, 160, 64);
+
+    framebuffer image;
+    double single = 0;
+    for (int threads = 1;; threads *= 2) {
+      threads = std::min(threads, tile_scheduler::hardware_threads());
+      s.cam.num_threads = threads;
+      auto t = time_render(s, image);
+      if (threads == 1)
+        single = t;
+
+      std::cout << std::setw(18) << entry.name << "  " << std::setw(3) << threads << " threads  "
+                << t << "s  speedup " << single / t << "x\n";
+      if (threads == tile_scheduler::hardware_threads())
+        break;
+    }
+  }
+}
+
+class counting_hittable : public hittable {
+  // Forwards to the wrapped object and counts the rays traced against it.
+ public:
+  explicit counting_hittable(shared_ptr<hittable> object) : object(std::move(object)) {}
+
+  bool hit(const ray& r, interval ray_t, hit_record& rec) const override {
+    rays.fetch_add(1, std::memory_order_relaxed);
+    return object->hit(r, ray_t, rec);
+  }
+
+  [[nodiscard]] AABB bounding_box() const override { return object->bounding_box(); }
+
+  mutable std::atomic<long long> rays{0};
+
+ private:
+  shared_ptr<hittable> object;
+};
+
+void bench_precision() {
+  // Scene memory, render time, ray throughput and mean brightness of every scene of main.cpp
+  // in the scalar type this benchmark was built with. The benchmark_float target builds the
+  // same benchmark with RTW_USE_FLOAT; compare its report with this one.
+  std::cout << "== precision (real = " << (sizeof(real) == sizeof(float) ? "float" : "double")
+            << ", sizeof(vec3) " << sizeof(vec3) << ", sizeof(hit_record) " << sizeof(hit_record)
+            << ") ==\n";
+
+  std::vector<named_scene> scenes = {
+      {"bouncing_spheres",  bouncing_spheres},
+      {"checkered_spheres", checkered_spheres},
+      {"earth",             earth},
+      {"perlin_spheres",    perlin_spheres},
+      {"quads",             quads},
+      {"quad_test",         quad_test},
+      {"simple_light",      simple_light},
+      {"cornell_box",       cornell_box},
+      {"cornell_smoke",     cornell_smoke},
+      {"final_scene",       small_final_scene},
+  };
+
+  for (const auto& entry : scenes) {
+    // Everything the scene allocates while it is built: objects, textures, BVH nodes.
+    auto bytes_before = allocation_bytes.load();
+    auto s = entry.build({});
+    auto scene_bytes = allocation_bytes.load() - bytes_before;
+
+    scale_down(s, 160, 32);
+    s.cam.deterministic = true;
+
+    auto counter = make_shared<counting_hittable>(make_shared<hittable_list>(s.world));
+    hittable_list counted(counter);
+
+    framebuffer image;
+    auto start = bench_clock::now();
+    image = s.cam.render_image(counted, s.lights);
+    std::chrono::duration<double> elapsed = bench_clock::now() - start;
+
+    std::cout << std::setw(18) << entry.name
+              << "  scene " << std::setw(9) << scene_bytes / 1024.0 << " KiB"
+              << "  " << elapsed.count() << "s"
+              << "  " << counter->rays.load() / elapsed.count() * 1e-6 << " Mrays/s"
+              << "  mean " << mean_luminance(image) << '\n';
+  }
+}
+
+double time_kernel(const std::function<void()>& kernel, int repeats) {
+  // Returns the best wall time of a kernel over several runs, in seconds.
+  double best = infinity;
+  for (int run = 0; run < 5; ++run) {
+    auto start = bench_clock::now();
+    for (int k = 0; k < repeats; ++k)
+      kernel();
+    std::chrono::duration<double> elapsed = bench_clock::now() - start;
+    best = std::fmin(best, elapsed.count());
+  }
+  return best;
+}
+
+// Coordinates of a batch of vectors, kept both as vec3 (AoS) and as coordinate arrays (SoA).
+struct vector_batch {
+  std::vector<vec3> aos;
+  std::vector<real> xs, ys, zs;
+
+  explicit vector_batch(size_t count, bool unit) {
+    for (size_t i = 0; i < count; ++i) {
+      auto v = unit ? random_unit_vector() : vec3::random(-1, 1);
+      aos.push_back(v);
+      xs.push_back(v.x());
+      ys.push_back(v.y());
+      zs.push_back(v.z());
+    }
+  }
+};
+
+template <int N, typename Kernel>
+void run_lanes(const vector_batch& a, const vector_batch& b, vector_batch& out, Kernel kernel) {
+  // Applies a kernel of vec3x<N> to the batches, N vectors at a time.
+  for (size_t i = 0; i < a.xs.size(); i += N) {
+    auto u = basic_vec3x<real, N>::load(&a.xs[i], &a.ys[i], &a.zs[i]);
+    auto v = basic_vec3x<real, N>::load(&b.xs[i], &b.ys[i], &b.zs[i]);
+    kernel(u, v).store(&out.xs[i], &out.ys[i], &out.zs[i]);
+  }
+}
+
+void bench_simd() {
+  // The vec3 kernels with the scalar vec3 and with the SIMD forms of vec3_simd.h, in
+  // nanoseconds per vector (per ray and box for the box test).
+  std::cout << "== simd (" << simd_isa() << ", real = "
+            << (sizeof(real) == sizeof(float) ? "float" : "double") << ") ==\n";
+
+  const size_t count = 4096;
+  const int repeats = 200;
+  seed_random(pcg32::default_seed);
+  vector_batch a(count, false), normals(count, true), out(count, false);
+
+  auto report = [&](const char* name, double scalar, double x4, double x8) {
+    auto ns = [&](double t) { return 1e9 * t / (double(count) * repeats); };
+    std::cout << std::setw(12) << name << "  vec3 " << ns(scalar) << " ns"
+              << "  vec3x4 " << ns(x4) << " ns (" << scalar / x4 << "x)"
+              << "  vec3x8 " << ns(x8) << " ns (" << scalar / x8 << "x)\n";
+  };
+
+  auto compare = [&](const char* name, auto scalar_kernel, auto lane_kernel) {
+    auto scalar = time_kernel([&] {
+      for (size_t i = 0; i < count; ++i)
+        out.aos[i] = scalar_kernel(a.aos[i], normals.aos[i]);
+    }, repeats);
+    auto x4 = time_kernel([&] { run_lanes<4>(a, normals, out, lane_kernel); }, repeats);
+    auto x8 = time_kernel([&] { run_lanes<8>(a, normals, out, lane_kernel); }, repeats);
+    report(name, scalar, x4, x8);
+  };
+
+  compare("normalize",
+          [](const vec3& v, const vec3&) { return unit_vector(v); },
+          [](const auto& v, const auto&) { return unit_vector(v); });
+  compare("cross",
+          [](const vec3& u, const vec3& v) { return cross(u, v); },
+          [](const auto& u, const auto& v) { return cross(u, v); });
+  compare("reflect",
+          [](const vec3& v, const vec3& n) { return reflect(v, n); },
+          [](const auto& v, const auto& n) { return reflect(v, n); });
+  compare("refract",
+          [](const vec3& v, const vec3& n) { return refract(unit_vector(v), n, 1.0 / 1.5); },
+          [](const auto& v, const auto& n) { return refract(unit_vector(v), n, real(1.0 / 1.5)); });
+
+  // One aligned vector at a time against vec3: the shape of the existing shading code.
+  {
+    std::vector<vec3a> aligned(count), aligned_normals(count);
+    for (size_t i = 0; i < count; ++i) {
+      aligned[i] = vec3a(a.aos[i]);
+      aligned_normals[i] = vec3a(normals.aos[i]);
+    }
+    std::vector<vec3a> aligned_out(count);
+
+    auto scalar = time_kernel([&] {
+      for (size_t i = 0; i < count; ++i)
+        out.aos[i] = unit_vector(cross(a.aos[i], normals.aos[i]));
+    }, repeats);
+    auto vector = time_kernel([&] {
+      for (size_t i = 0; i < count; ++i)
+        aligned_out[i] = unit_vector(cross(aligned[i], aligned_normals[i]));
+    }, repeats);
+    std::cout << std::setw(12) << "vec3a" << "  unit(cross) vec3 " << 1e9 * scalar / (count * repeats)
+              << " ns  vec3a " << 1e9 * vector / (count * repeats) << " ns (" << scalar / vector << "x)\n";
+  }
+
+  // The packet box test against AABB::hit for every lane.
+  {
+    std::vector<AABB> boxes;
+    for (int k = 0; k < 64; ++k) {
+      auto c = vec3::random(-4, 4);
+      boxes.emplace_back(c - vec3(0.5, 0.5, 0.5), c + vec3(0.5, 0.5, 0.5));
+    }
+
+    ray_packet packet;
+    for (int lane = 0; lane < packet_width; ++lane)
+      packet.add(ray(point3(0, 0, -10), unit_vector(vec3(0, 0, 10) + vec3::random(-2, 2))), pcg32());
+    packet.finalize();
+
+    unsigned hits = 0;
+    const int box_repeats = 20000;
+    auto scalar = time_kernel([&] {
+      for (const auto& box : boxes)
+        for (int lane = 0; lane < packet.size; ++lane)
+          hits += box.hit(packet.rays[lane], interval(packet.t_min, packet.t_max[lane]));
+    }, box_repeats);
+    auto lanes = time_kernel([&] {
+      for (const auto& box : boxes)
+        hits += lane_count(packet.hit_mask(box, packet.full_mask()));
+    }, box_repeats);
+
+    auto tests = double(boxes.size()) * packet_width * box_repeats;
+    std::cout << std::setw(12) << "box test" << "  AABB::hit " << 1e9 * scalar / tests
+              << " ns  hit_mask " << 1e9 * lanes / tests << " ns (" << scalar / lanes << "x)"
+              << "  (" << hits % 2 << ")\n";
+  }
+
+  // AABB::hit alone on random rays, each aimed close to a random box of its own so that
+  // about half of them hit and the outcome of every test is unpredictable.
+  {
+    std::vector<AABB> boxes;
+    std::vector<ray> rays;
+    for (int k = 0; k < 4096; ++k) {
+      auto c = vec3::random(-4, 4);
+      auto half = vec3::random(0.1, 1);
+      boxes.emplace_back(c - half, c + half);
+      auto origin = vec3::random(-8, 8);
+      rays.emplace_back(origin, unit_vector(c + 1.5 * vec3::random(-1, 1) - origin));
+    }
+
+    long long hits = 0;
+    const int box_repeats = 200;
+    auto t = time_kernel([&] {
+      for (size_t k = 0; k < boxes.size(); ++k)
+        hits += boxes[k].hit(rays[k], interval(0.001, infinity));
+    }, box_repeats);
+
+    auto tests = double(boxes.size()) * box_repeats;
+    std::cout << std::setw(12) << "box random" << "  AABB::hit " << 1e9 * t / tests << " ns  ("
+              << 100.0 * hits / (5 * tests) << "% hit)\n";
+  }
+
+  // Keep the results alive.
+  double sink = 0;
+  for (size_t i = 0; i < count; ++i)
+    sink += out.aos[i].x() + out.xs[i];
+  std::cout << std::setw(12) << "checksum" << "  " << sink << '\n';
+}
+
+void bench_bvh() {
+  // The median, SAH and LBVH builders, and the SAH tree collapsed to widths 4 and 8: build
+  // time, SAH cost and memory of the largest BVH of the scene, then node boxes and
+  // primitives tested per ray (a wide node counts one box per child), the render time and
+  // the rays traced per second.
+  std::cout << "== bvh ==\n";
+
+  std::vector<named_scene> scenes = benchmark_scenes();
+  scenes.push_back({"cornell_smoke", cornell_smoke});
+  scenes.push_back({"final_scene",   small_final_scene});
+
+  struct builder { const char* name; bvh_split split; int width; };
+
+  for (const auto& entry : scenes) {
+    for (auto b : {builder{"median", bvh_split::median, 2}, builder{"sah   ", bvh_split::sah, 2},
+                   builder{"sah4  ", bvh_split::sah, 4}, builder{"sah8  ", bvh_split::sah, 8},
+                   builder{"lbvh  ", bvh_split::lbvh, 2}}) {
+      bvh_build_options options;
+      options.split = b.split;
+      options.width = b.width;
+
+      auto start = bench_clock::now();
+      auto s = entry.build(options);
+      std::chrono::duration<double> build_time = bench_clock::now() - start;
+
+      bvh_quality quality;
+      for (const auto& object : s.world.objects)
+        if (auto node = std::dynamic_pointer_cast<bvh_node>(object)) {
+          auto q = node->quality();
+          if (q.nodes > quality.nodes)
+            quality = q;
+        }
+
+      scale_down(s, 160, 16);
+      s.cam.deterministic = true;
+      s.cam.num_threads   = 1;
+
+      auto counter = make_shared<counting_hittable>(make_shared<hittable_list>(s.world));
+      hittable_list counted(counter);
+
+      traversal_stats::reset();
+      start = bench_clock::now();
+      auto image = s.cam.render_image(counted, s.lights);
+      std::chrono::duration<double> render_time = bench_clock::now() - start;
+      auto counts = traversal_stats::collect();
+      auto rays = double(counter->rays.load());
+
+      std::cout << std::setw(18) << entry.name << "  " << b.name
+                << "  build " << 1e3 * build_time.count() << "ms"
+                << "  nodes " << std::setw(5) << quality.nodes << "  depth " << std::setw(2) << quality.max_depth
+                << "  sah " << std::setw(7) << quality.sah_cost
+                << "  " << std::setw(5) << quality.bytes / 1024 << "kB"
+                << "  boxes/ray " << std::setw(7) << counts.box_tests / rays
+                << "  prims/ray " << std::setw(6) << counts.primitive_tests / rays
+                << "  render " << render_time.count() << "s"
+                << "  " << std::setw(6) << 1e-6 * rays / render_time.count() << " Mrays/s\n";
+    }
+  }
+}
+
+hittable_list sphere_field(int half_grid) {
+  // The small spheres of bouncing_spheres, on a grid of 2 * half_grid cells per side.
+  hittable_list field;
+  for (int a = -half_grid; a < half_grid; ++a) {
+    for (int b = -half_grid; b < half_grid; ++b) {
+      auto choose_mat = random_double();
+      point3 center(a + 0.9 * random_double(), 0.2, b + 0.9 * random_double());
+
+      shared_ptr<material> sphere_material;
+      if (choose_mat < 0.8)
+        sphere_material = make_shared<lambertian>(color::random() * color::random());
+      else if (choose_mat < 0.95)
+        sphere_material = make_shared<metal>(color::random(0.5, 1), random_double(0, 0.5));
+      else
+        sphere_material = make_shared<dielectric>(1.5);
+      field.add(make_shared<sphere>(center, 0.2, sphere_material));
+    }
+  }
+  return field;
+}
+
+void bench_build() {
+  // BVH construction on bouncing_spheres scaled up to a million spheres: the time to create
+  // the spheres and to build the tree (together, the wait before the first ray), the
+  // quality of the tree and the speed of tracing random rays through it.
+  std::cout << "== build (" << tile_scheduler::hardware_threads() << " hardware threads) ==\n";
+
+  struct builder { const char* name; bvh_split split; };
+  for (int half_grid : {50, 158, 500}) {
+    seed_random(pcg32::default_seed);
+    auto start = bench_clock::now();
+    auto field = sphere_field(half_grid);
+    std::chrono::duration<double> scene_time = bench_clock::now() - start;
+
+    std::vector<ray> rays;
+    for (int i = 0; i < 200000; ++i) {
+      point3 origin(random_double(-half_grid, half_grid), random_double(0.5, 2), random_double(-half_grid, half_grid));
+      rays.emplace_back(origin, random_unit_vector());
+    }
+
+    for (auto b : {builder{"sah ", bvh_split::sah}, builder{"lbvh", bvh_split::lbvh}}) {
+      for (int threads = 1;; threads *= 2) {
+        threads = std::min(threads, tile_scheduler::hardware_threads());
+
+        bvh_build_options options;
+        options.split = b.split;
+        options.threads = threads;
+        start = bench_clock::now();
+        bvh_node bvh(field, options);
+        std::chrono::duration<double> build_time = bench_clock::now() - start;
+        auto quality = bvh.quality();
+
+        hit_record rec;
+        start = bench_clock::now();
+        for (const auto& r : rays)
+          bvh.hit(r, interval(0.001, infinity), rec);
+        std::chrono::duration<double> trace_time = bench_clock::now() - start;
+
+        std::cout << std::setw(8) << field.objects.size() << " spheres  " << b.name
+                  << std::setw(3) << threads << " threads"
+                  << "  scene " << std::setw(8) << 1e3 * scene_time.count() << "ms"
+                  << "  build " << std::setw(8) << 1e3 * build_time.count() << "ms"
+                  << "  first ray " << std::setw(8) << 1e3 * (scene_time + build_time).count() << "ms"
+                  << "  sah " << std::setw(6) << quality.sah_cost << "  depth " << std::setw(2) << quality.max_depth
+                  << "  " << std::setw(6) << 1e-6 * rays.size() / trace_time.count() << " Mrays/s\n";
+        if (threads == tile_scheduler::hardware_threads())
+          break;
+      }
+    }
+  }
+}
+
+void bench_instances() {
+  // A model of a thousand spheres (the cluster of final_scene) copied many times with random
+  // rotations, scales and translations: as instances of one shared BVH under a top-level BVH,
+  // and with the spheres of every copy transformed into one flat BVH. Memory is that of the
+  // objects and nodes. Then the cost of the cluster's translate(rotate_y()) chain against the
+  // single instance it collapses to.
+  std::cout << "== instances ==\n";
+
+  seed_random(pcg32::default_seed);
+  auto white = make_shared<lambertian>(color(.73, .73, .73));
+  std::vector<point3> centers;
+  hittable_list model;
+  for (int j = 0; j < 1000; ++j) {
+    centers.push_back(point3::random(0, 165));
+    model.add(make_shared<sphere>(centers.back(), 10, white));
+  }
+  auto blas = make_shared<bvh_node>(model);
+  const size_t model_bytes = centers.size() * sizeof(sphere) + blas->quality().bytes;
+
+  for (int side : {16, 32}) {
+    // One copy per cell of a side x side grid.
+    const real spacing = 300;
+    std::vector<affine_transform> placements;
+    std::vector<real> scales;
+    for (int i = 0; i < side; ++i)
+      for (int k = 0; k < side; ++k) {
+        auto scale = random_double(0.5, 1.5);
+        scales.push_back(scale);
+        placements.push_back(affine_transform::translation(vec3(i * spacing, 0, k * spacing))
+                             * affine_transform::rotation(random_unit_vector(), random_double(0, 360))
+                             * affine_transform::scaling(vec3(scale, scale, scale)));
+      }
+
+    std::vector<ray> rays;
+    for (int i = 0; i < 100000; ++i) {
+      point3 origin(random_double(0, side * spacing), random_double(0, 200), random_double(0, side * spacing));
+      rays.emplace_back(origin, random_unit_vector());
+    }
+
+    auto trace = [&](const hittable& world) {
+      hit_record rec;
+      int hits = 0;
+      auto start = bench_clock::now();
+      for (const auto& r : rays)
+        hits += world.hit(r, interval(0.001, infinity), rec);
+      std::chrono::duration<double> time = bench_clock::now() - start;
+      return std::make_pair(1e-6 * rays.size() / time.count(), 100.0 * hits / rays.size());
+    };
+
+    auto report = [&](const char* name, double build_ms, size_t bytes, std::pair<double, double> speed) {
+      std::cout << std::setw(6) << placements.size() << " copies  " << name
+                << "  build " << std::setw(8) << build_ms << "ms"
+                << "  memory " << std::setw(8) << bytes / 1024 << "kB"
+                << "  " << std::setw(6) << speed.first << " Mrays/s  (" << speed.second << "% hit)\n";
+    };
+
+    {
+      hittable_list instances;
+      auto start = bench_clock::now();
+      for (const auto& placement : placements)
+        instances.add(make_shared<instance>(blas, placement));
+      bvh_node tlas(instances);
+      std::chrono::duration<double> build_time = bench_clock::now() - start;
+      auto bytes = model_bytes + placements.size() * sizeof(instance) + tlas.quality().bytes;
+      report("instanced", 1e3 * build_time.count(), bytes, trace(tlas));
+    }
+
+    {
+      hittable_list copies;
+      auto start = bench_clock::now();
+      for (size_t c = 0; c < placements.size(); ++c)
+        for (const auto& center : centers)
+          copies.add(make_shared<sphere>(placements[c].point(center), 10 * scales[c], white));
+      bvh_node flat(copies);
+      std::chrono::duration<double> build_time = bench_clock::now() - start;
+      auto bytes = copies.objects.size() * sizeof(sphere) + flat.quality().bytes;
+      report("flat     ", 1e3 * build_time.count(), bytes, trace(flat));
+    }
+  }
+
+  // Rays at the cluster of final_scene, through its former wrapper chain and its instance.
+  std::vector<ray> rays;
+  for (int i = 0; i < 200000; ++i) {
+    point3 origin(random_double(-300, 100), random_double(200, 500), random_double(300, 600));
+    rays.emplace_back(origin, random_unit_vector());
+  }
+  auto chain = make_shared<translate>(make_shared<rotate_y>(blas, 15), vec3(-100, 270, 395));
+  auto collapsed = collapse_transforms(chain);
+  const std::pair<const char*, const hittable*> variants[] = {
+      {"translate(rotate_y)", chain.get()}, {"instance           ", collapsed.get()}};
+  for (auto [name, object] : variants) {
+    hit_record rec;
+    int hits = 0;
+    auto start = bench_clock::now();
+    for (const auto& r : rays)
+      hits += object->hit(r, interval(0.001, infinity), rec);
+    std::chrono::duration<double> time = bench_clock::now() - start;
+    std::cout << "  cluster " << name << "  " << 1e9 * time.count() / rays.size() << " ns/ray  ("
+              << 100.0 * hits / rays.size() << "% hit)\n";
+  }
+}
+
+void bench_motion() {
+  // BVH boxes and primitives tested per ray, and rays traced per second, with the
+  // boxes swept over the whole shutter, with bounds interpolated at the time of every ray,
+  // and with the shutter also split into time segments. First bouncing_spheres, whose small
+  // spheres move up by up to half a unit, then grids of spheres moving in random directions
+  // by up to 1 and 8 units, traced with random rays at random times.
+  std::cout << "== motion ==\n";
+
+  struct variant { const char* name; bool motion_blur; int segments; };
+  const variant variants[] = {{"swept     ", false, 0}, {"motion    ", true, 1},
+                              {"motion x4 ", true, 4}, {"motion auto", true, 0}};
+
+  auto report = [](const std::string& scene, const variant& v, const bvh_quality& quality,
+                   const traversal_counts& counts, double rays, double seconds) {
+    std::cout << std::setw(18) << scene << "  " << v.name << "  segments " << quality.segments
+              << "  " << std::setw(6) << quality.bytes / 1024 << "kB"
+              << "  boxes/ray " << std::setw(7) << counts.box_tests / rays
+              << "  prims/ray " << std::setw(6) << counts.primitive_tests / rays
+              << "  " << std::setw(6) << 1e-6 * rays / seconds << " Mrays/s\n";
+  };
+
+  for (const auto& v : variants) {
+    bvh_build_options options;
+    options.motion_blur = v.motion_blur;
+    options.motion_segments = v.segments;
+
+    seed_random(pcg32::default_seed);
+    auto s = bouncing_spheres(options);
+    bvh_quality quality;
+    for (const auto& object : s.world.objects)
+      if (auto node = std::dynamic_pointer_cast<bvh_node>(object))
+        quality = node->quality();
+
+    scale_down(s, 160, 16);
+    s.cam.deterministic = true;
+    s.cam.num_threads   = 1;
+    auto counter = make_shared<counting_hittable>(make_shared<hittable_list>(s.world));
+    hittable_list counted(counter);
+
+    traversal_stats::reset();
+    auto start = bench_clock::now();
+    s.cam.render_image(counted, s.lights);
+    std::chrono::duration<double> render_time = bench_clock::now() - start;
+    report("bouncing_spheres", v, quality, traversal_stats::collect(), double(counter->rays.load()),
+           render_time.count());
+  }
+
+  for (double distance : {1.0, 8.0}) {
+    seed_random(pcg32::default_seed);
+    auto white = make_shared<lambertian>(color(.73, .73, .73));
+    hittable_list field;
+    for (int a = -100; a < 100; ++a)
+      for (int b = -100; b < 100; ++b) {
+        point3 center(a + 0.9 * random_double(), 0.2 + random_double(), b + 0.9 * random_double());
+        field.add(make_shared<sphere>(center, center + random_double(0, distance) * random_unit_vector(), 0.2, white));
+      }
+
+    std::vector<ray> rays;
+    for (int i = 0; i < 200000; ++i) {
+      point3 origin(random_double(-100, 100), random_double(0.5, 2), random_double(-100, 100));
+      rays.emplace_back(origin, random_unit_vector(), random_double());
+    }
+
+    std::ostringstream scene;
+    scene << "field moving " << distance;
+    for (const auto& v : variants) {
+      bvh_build_options options;
+      options.motion_blur = v.motion_blur;
+      options.motion_segments = v.segments;
+      bvh_node bvh(field, options);
+
+      // One pass to bring the tree into the caches, then the measured one.
+      hit_record rec;
+      for (const auto& r : rays)
+        bvh.hit(r, interval(0.001, infinity), rec);
+      traversal_stats::reset();
+      auto start = bench_clock::now();
+      for (const auto& r : rays)
+        bvh.hit(r, interval(0.001, infinity), rec);
+      std::chrono::duration<double> trace_time = bench_clock::now() - start;
+      report(scene.str(), v, bvh.quality(), traversal_stats::collect(), double(rays.size()), trace_time.count());
+    }
+  }
+}
+
+void bench_triangles() {
+  // Triangle tests per second on one core: random rays against a batch of random triangles,
+  // as tri objects through the virtual quad::hit and is_interior, and as triangle_packs.
+  // Both keep the closest hit of every ray, so they must find the same hits.
+  std::cout << "== triangles (" << simd_isa() << ", " << triangle_pack::width << " per pack) ==\n";
+  const int count = 4096;
+  const int ray_count = 2000;
+  seed_random(pcg32::default_seed);
+
+  std::vector<shared_ptr<hittable>> tris;
+  std::vector<triangle_pack> packs((count + triangle_pack::width - 1) / triangle_pack::width);
+  for (int i = 0; i < count; ++i) {
+    point3 a = vec3::random(-1, 1);
+    vec3 u = 0.2 * random_unit_vector(), v = 0.2 * random_unit_vector();
+    tris.push_back(make_shared<tri>(a, u, v, nullptr));
+    packs[i / triangle_pack::width].set(i % triangle_pack::width, a, a + u, a + v, static_cast<uint32_t>(i));
+  }
+
+  std::vector<ray> rays;
+  for (int i = 0; i < ray_count; ++i)
+    rays.emplace_back(2 * random_unit_vector(), random_unit_vector());
+
+  auto run = [&](const char* name, const std::function<real(const ray&)>& closest) {
+    int hits = 0;
+    double time = time_kernel([&] {
+      hits = 0;
+      for (const auto& r : rays)
+        hits += closest(r) < infinity;
+    }, 1);
+    std::cout << std::setw(14) << name << "  " << std::setw(8) << 1e-6 * double(count) * ray_count / time
+              << " Mtris/s  (" << hits << " rays hit)\n";
+    return time;
+  };
+
+  auto scalar = run("tri::hit", [&](const ray& r) {
+    hit_record rec;
+    real closest = infinity;
+    for (const auto& object : tris)
+      if (object->hit(r, interval(0.001, closest), rec))
+        closest = rec.t;
+    return closest;
+  });
+  auto batched = run("triangle_pack", [&](const ray& r) {
+    real closest = infinity, t, b1, b2;
+    for (const auto& pack : packs)
+      if (pack.hit(r, interval(0.001, closest), t, b1, b2) >= 0)
+        closest = t;
+    return closest;
+  });
+  std::cout << std::setw(14) << "speedup" << "  " << std::setw(8) << scalar / batched << "x\n";
+}
+
+void write_torus_obj(const std::string& filename, int rings, int sides) {
+  // A torus of rings x sides quads, with normals and texture coordinates, as an OBJ file.
+  std::ofstream out(filename, std::ios::binary);
+  out << std::setprecision(7);
+  const double major = 1.0, minor = 0.35;
+  for (int i = 0; i < rings; ++i)
+    for (int j = 0; j < sides; ++j) {
+      double a = 2 * pi * i / rings, b = 2 * pi * j / sides;
+      double r = major + minor * std::cos(b);
+      out << "v " << r * std::cos(a) << ' ' << minor * std::sin(b) << ' ' << r * std::sin(a) << '\n'
+          << "vn " << std::cos(b) * std::cos(a) << ' ' << std::sin(b) << ' ' << std::cos(b) * std::sin(a) << '\n'
+          << "vt " << double(i) / rings << ' ' << double(j) / sides << '\n';
+    }
+  for (int i = 0; i < rings; ++i)
+    for (int j = 0; j < sides; ++j) {
+      int corners[4] = {i * sides + j, ((i + 1) % rings) * sides + j,
+                        ((i + 1) % rings) * sides + (j + 1) % sides, i * sides + (j + 1) % sides};
+      out << 'f';
+      for (int c : corners)
+        out << ' ' << c + 1 << '/' << c + 1 << '/' << c + 1;
+      out << '\n';
+    }
+}
+
+void bench_mesh() {
+  // Torus meshes written as OBJ files: the speed of loading them on one and on all threads,
+  // the memory per triangle of a triangle_mesh (arrays and BVH) against the same triangles
+  // as tri objects in a bvh_node, and the speed of tracing random rays through both.
+  std::cout << "== mesh ==\n";
+  auto grey = make_shared<lambertian>(color(.5, .5, .5));
+  auto filename = (std::filesystem::temp_directory_path() / "rtw_benchmark_mesh.obj").string();
+
+  for (int rings : {256, 1024}) {
+    write_torus_obj(filename, rings, rings / 2);
+    double megabytes = 1e-6 * static_cast<double>(std::filesystem::file_size(filename));
+
+    mesh_data data;
+    for (int threads = 1;; threads *= 2) {
+      threads = std::min(threads, tile_scheduler::hardware_threads());
+      auto start = bench_clock::now();
+      data = load_obj(filename, threads);
+      std::chrono::duration<double> load_time = bench_clock::now() - start;
+      std::cout << std::setw(8) << data.triangle_count() << " triangles  " << std::setw(6) << megabytes << " MB"
+                << std::setw(3) << threads << " threads  load " << std::setw(8) << 1e3 * load_time.count() << "ms  "
+                << std::setw(7) << megabytes / load_time.count() << " MB/s  "
+                << std::setw(6) << 1e-6 * data.triangle_count() / load_time.count() << " Mtris/s\n";
+      if (threads == tile_scheduler::hardware_threads())
+        break;
+    }
+
+    size_t count = data.triangle_count();
+    std::vector<ray> rays;
+    for (int i = 0; i < 200000; ++i)
+      rays.emplace_back(point3(random_double(-1.5, 1.5), random_double(-0.5, 0.5), random_double(-1.5, 1.5)),
+                        random_unit_vector());
+    auto trace = [&](const hittable& object) {
+      hit_record rec;
+      int hits = 0;
+      auto start = bench_clock::now();
+      for (const auto& r : rays)
+        hits += object.hit(r, interval(0.001, infinity), rec);
+      std::chrono::duration<double> time = bench_clock::now() - start;
+      std::ostringstream result;
+      result << std::fixed << std::setprecision(3) << std::setw(6) << 1e-6 * rays.size() / time.count()
+             << " Mrays/s  (" << 100.0 * hits / rays.size() << "% hit)";
+      return result.str();
+    };
+
+    {
+      // The same triangles as tri objects; their memory is what their allocation takes.
+      hittable_list triangles;
+      triangles.objects.reserve(count);
+      auto allocated = allocation_bytes.load();
+      for (size_t i = 0; i < count; ++i) {
+        const auto& p = data.positions;
+        const uint32_t* c = &data.position_indices[3 * i];
+        triangles.add(make_shared<tri>(p[c[0]], p[c[1]] - p[c[0]], p[c[2]] - p[c[0]], grey));
+      }
+      auto object_bytes = static_cast<size_t>(allocation_bytes.load() - allocated)
+                          + count * sizeof(shared_ptr<hittable>);
+      auto start = bench_clock::now();
+      bvh_node bvh(triangles);
+      std::chrono::duration<double> build_time = bench_clock::now() - start;
+      auto bytes = object_bytes + bvh.quality().bytes;
+      std::cout << std::setw(8) << count << " triangles  tri objects     "
+                << std::setw(6) << double(bytes) / count << " bytes/triangle  build "
+                << std::setw(8) << 1e3 * build_time.count() << "ms  " << trace(bvh) << '\n';
+    }
+
+    auto start = bench_clock::now();
+    triangle_mesh mesh(std::move(data), grey);
+    std::chrono::duration<double> build_time = bench_clock::now() - start;
+    std::cout << std::setw(8) << count << " triangles  triangle_mesh   "
+              << std::setw(6) << double(mesh.bytes()) / count << " bytes/triangle  build "
+              << std::setw(8) << 1e3 * build_time.count() << "ms  " << trace(mesh) << '\n';
+  }
+
+  std::filesystem::remove(filename);
+}
+
+int main(int argc, char* argv[]) {
+  // The renderer reports progress on std::clog; keep the benchmark output readable.
+  std::clog.rdbuf(nullptr);
+  std::cout << std::fixed << std::setprecision(3);
+
+  std::string which = argc > 1 ? argv[1] : "all";
+
+  if (which == "all" || which == "determinism") bench_determinism();
+  if (which == "all" || which == "progressive") bench_progressive();
+  if (which == "all" || which == "adaptive")    bench_adaptive();
+  if (which == "all" || which == "roulette")    bench_roulette();
+  if (which == "all" || which == "wavefront")   bench_wavefront();
+  if (which == "all" || which == "packets")     bench_packets();
+  if (which == "all" || which == "output")      bench_output();
+  if (which == "all" || which == "allocations") bench_allocations();
+  if (which == "all" || which == "scaling")     bench_scaling();
+  if (which == "all" || which == "precision")   bench_precision();
+  if (which == "all" || which == "simd")        bench_simd();
+  if (which == "all" || which == "bvh")         bench_bvh();
+  if (which == "all" || which == "build")       bench_build();
+  if (which == "all" || which == "instances")   bench_instances();
+  if (which == "all" || which == "motion")      bench_motion();
+  if (which == "all" || which == "mesh")        bench_mesh();
+  if (which == "all" || which == "triangles")   bench_triangles();
+}